@@ -137,6 +137,13 @@ public:
 // Let us check the ds concept.
 static_assert(gdyn::concepts::system<Bonobo>);
 
+// Commands can be enumerated.
+template<>
+struct gdyn::enumerable<Bonobo::letter> {
+  static constexpr std::array values {Bonobo::letter::B, Bonobo::letter::O, Bonobo::letter::N};
+};
+static_assert(gdyn::concepts::enumerable<Bonobo::command_type>);
+
 // Here are some usefull prints
 
 inline std::ostream& operator<<(std::ostream& os, Bonobo::command_type action) {
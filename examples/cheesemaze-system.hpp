@@ -1,8 +1,15 @@
 #pragma once // HFB: c'est pas standard stricto sensu... mais c'est mieux non ?
 
 
-#include <tuple>
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include <gdyn.hpp>
 
@@ -251,4 +258,267 @@ namespace cheese_maze {
 }
 
 
+  // *************************************************************************
+  // ****************************************************************** Belief
+  // *************************************************************************
+
+  // A belief is a probability distribution over the cells. As the
+  // maze is small and its dynamics is known, beliefs can be updated
+  // exactly (Bayes filter).
+  using Belief = std::array<double, nbCell>;
+
+  // This is the model of the maze, precomputed from an environment.
+  // The observation of a cell is its walls, and whether it is
+  // terminal or not (the episode goes on only out of C10).
+  class BeliefModel {
+  private:
+    // transition[a][s][s'] is the probability to reach s' when a is
+    // performed from s. The rows are contiguous, so that the
+    // prediction step loops over s' (vectorizable).
+    std::array<std::array<Belief, nbCell>, nbDir> transition {};
+    // likelihood[w][t][s] is the probability to observe the walls w
+    // and the terminal flag t from s (0 or 1 here).
+    std::array<std::array<Belief, 2>, nbWalls> likelihood {};
+
+  public:
+    template<typename RG>
+    BeliefModel(const Environment<RG>& env) {
+      double p = env.param.mishap_proba;
+      for(int s = 0; s < nbCell; ++s) {
+        for(int a = 0; a < nbDir; ++a) {
+          auto& row = transition[a][s];
+          if(static_cast<Cell>(s) == Cell::C10) { // The environment never leaves C10.
+            row[s] = 1;
+            continue;
+          }
+          row[static_cast<int>(env.neighbors[s][a])] += 1 - p;
+          for(int d = 0; d < nbDir; ++d)
+            row[static_cast<int>(env.neighbors[s][d])] += p / nbDir;
+        }
+        int terminal = (static_cast<Cell>(s) == Cell::C10) ? 1 : 0;
+        likelihood[static_cast<int>(env.local_view[s])][terminal][s] = 1;
+      }
+    }
+
+    // This is the probability to reach to when command is performed
+    // from from.
+    double operator()(Cell from, Dir command, Cell to) const {
+      return transition[static_cast<int>(command)][static_cast<int>(from)][static_cast<int>(to)];
+    }
+
+    // This is the belief when nothing but the first observation is
+    // known (the starting cell being uniformly drawn).
+    Belief prior(Walls observation, bool terminal) const {
+      Belief res = likelihood[static_cast<int>(observation)][terminal ? 1 : 0];
+      double sum = 0;
+      for(auto b : res) sum += b;
+      for(auto& b : res) b /= sum;
+      return res;
+    }
+
+    // This writes in out the belief after performing command and
+    // observing (observation, terminal), from belief. out and belief
+    // must not overlap.
+    void update(const double* belief, Dir command, Walls observation, bool terminal, double* out) const {
+      const auto& t = transition[static_cast<int>(command)];
+      const auto& l = likelihood[static_cast<int>(observation)][terminal ? 1 : 0];
+      for(int s = 0; s < nbCell; ++s) out[s] = 0;
+      for(int s = 0; s < nbCell; ++s) {
+        double b = belief[s];
+        const double* row = t[s].data();
+        for(int next = 0; next < nbCell; ++next) out[next] += b * row[next];
+      }
+      double sum = 0;
+      for(int s = 0; s < nbCell; ++s) sum += (out[s] *= l[s]);
+      if(sum == 0) { // The observation contradicts the belief.
+        auto p = prior(observation, terminal);
+        std::copy(p.begin(), p.end(), out);
+        return;
+      }
+      double w = 1 / sum;
+      for(int s = 0; s < nbCell; ++s) out[s] *= w;
+    }
+
+    Belief update(const Belief& belief, Dir command, Walls observation, bool terminal) const {
+      Belief res;
+      update(belief.data(), command, observation, terminal, res.data());
+      return res;
+    }
+  }; // class BeliefModel
+
+
+  /**
+     This wraps an environment so that its observation is the exact
+     belief over the cells, updated at each transition. It is a
+     gdyn::system and a gdyn::transparent_system.
+  */
+  template<typename RG>
+  class BeliefEnvironment {
+    Environment<RG>& base;
+    BeliefModel model;
+    Belief belief;
+
+  public:
+    using observation_type = Belief;
+    using command_type     = Dir;
+    using state_type       = Cell;
+    using report_type      = double;
+
+    BeliefEnvironment(Environment<RG>& base)
+      : base(base), model(base), belief(model.prior(*base, !base)) {}
+
+    BeliefEnvironment& operator=(const state_type& init_state) {
+      base = init_state;
+      belief = model.prior(*base, !base);
+      return *this;
+    }
+    observation_type operator*() const {return belief;}
+    state_type state() const           {return base.state();}
+    operator bool() const              {return base;}
+    report_type operator()(command_type command) {
+      auto report = base(command);
+      belief = model.update(belief, command, *base, !base);
+      return report;
+    }
+  }; // class BeliefEnvironment
+
+  template<typename RG>
+  auto make_belief_environment(Environment<RG>& base) {
+    return BeliefEnvironment<RG>(base);
+  }
+
+
+  /**
+     This filters the beliefs of many agents at once, e.g. agents
+     driving a batch of environments. The beliefs are stored in a
+     single array, a row per lane.
+  */
+  class BeliefBatch {
+    BeliefModel model;
+    std::vector<double> beliefs;
+    std::vector<double> next;
+
+  public:
+    BeliefBatch(const BeliefModel& model, std::size_t size)
+      : model(model), beliefs(size * nbCell), next(size * nbCell) {}
+
+    std::size_t size() const {return beliefs.size() / nbCell;}
+
+    // This sets the belief of lane i from its first observation.
+    void set(std::size_t i, Walls observation, bool terminal) {
+      auto p = model.prior(observation, terminal);
+      std::copy(p.begin(), p.end(), beliefs.begin() + i * nbCell);
+    }
+
+    std::span<const double, nbCell> operator[](std::size_t i) const {
+      return std::span<const double, nbCell>(beliefs.data() + i * nbCell, nbCell);
+    }
+
+    // This updates the belief of each lane i, after commands[i] has
+    // been performed, leading to (observations[i], terminals[i]).
+    // There must be a value per lane in each span.
+    void operator()(std::span<const Dir> commands, std::span<const Walls> observations, std::span<const unsigned char> terminals,
+                    unsigned int nb_threads = std::thread::hardware_concurrency()) {
+      if(commands.size() != size() || observations.size() != size() || terminals.size() != size())
+        throw std::invalid_argument("cheese_maze::BeliefBatch : there must be a command, an observation and a terminal flag per lane");
+      constexpr std::size_t block_size = 1024;
+      std::size_t n = size();
+      gdyn::parallel::for_each_index((n + block_size - 1) / block_size,
+                                     [this, commands, observations, terminals, n](std::size_t b) {
+                                       std::size_t last = std::min(n, (b + 1) * block_size);
+                                       for(std::size_t i = b * block_size; i < last; ++i)
+                                         model.update(beliefs.data() + i * nbCell, commands[i], observations[i], terminals[i],
+                                                      next.data() + i * nbCell);
+                                     },
+                                     nb_threads);
+      std::swap(beliefs, next);
+    }
+  }; // class BeliefBatch
+
+
+  /**
+     These are the particles of a particle filter estimating the cell
+     from the walls and the terminal flag (see
+     gdyn::system::particle_filter), i.e. the observation model of
+     BeliefModel. The estimate is the proportion of the weights in
+     each cell, i.e. an approximation of the exact belief.
+  */
+  class Particles {
+    std::array<std::array<int, nbDir>, nbCell> neighbors;
+    std::array<Walls, nbCell> local_view;
+    double mishap_proba;
+    std::vector<int> cells;
+
+  public:
+    using estimate_type = Belief;
+
+    template<typename RG>
+    Particles(const Environment<RG>& env, std::size_t size)
+      : local_view(env.local_view), mishap_proba(env.param.mishap_proba), cells(size) {
+      for(int s = 0; s < nbCell; ++s)
+        for(int d = 0; d < nbDir; ++d) neighbors[s][d] = static_cast<int>(env.neighbors[s][d]);
+    }
+
+    std::size_t size() const {return cells.size();}
+
+    template<typename RANDOM_GENERATOR>
+    void reset(Walls observation, bool terminal, std::size_t first, std::size_t last, RANDOM_GENERATOR& gen) {
+      std::array<int, nbCell> candidates;
+      int nb = 0;
+      for(int s = 0; s < nbCell; ++s)
+        if(local_view[s] == observation && (static_cast<Cell>(s) == Cell::C10) == terminal) candidates[nb++] = s;
+      std::uniform_int_distribution<int> pick(0, nb - 1);
+      for(std::size_t i = first; i < last; ++i) cells[i] = candidates[pick(gen)];
+    }
+
+    template<typename RANDOM_GENERATOR>
+    void move(Dir command, std::size_t first, std::size_t last, RANDOM_GENERATOR& gen) {
+      std::uniform_real_distribution<double> u(0, 1);
+      std::uniform_int_distribution<int> d(0, nbDir - 1);
+      for(std::size_t i = first; i < last; ++i) {
+        int c = cells[i];
+        if(static_cast<Cell>(c) == Cell::C10) continue; // The terminal cell is absorbing.
+        cells[i] = neighbors[c][u(gen) < mishap_proba ? d(gen) : static_cast<int>(command)];
+      }
+    }
+
+    void log_likelihood(Walls observation, bool terminal, std::size_t first, std::size_t last, double* out) const {
+      for(std::size_t i = first; i < last; ++i)
+        out[i] = local_view[cells[i]] == observation && (static_cast<Cell>(cells[i]) == Cell::C10) == terminal
+          ? 0 : -std::numeric_limits<double>::infinity();
+    }
+
+    void resample(std::span<const std::size_t> ancestors) {
+      std::vector<int> c(size());
+      for(std::size_t i = 0; i < ancestors.size(); ++i) c[i] = cells[ancestors[i]];
+      cells = std::move(c);
+    }
+
+    Belief estimate(std::span<const double> weights) const {
+      Belief res {};
+      for(std::size_t i = 0; i < size(); ++i) res[cells[i]] += weights[i];
+      return res;
+    }
+  }; // class Particles
+
+
 } // namespace cheese_maze
+
+// The cheese maze types can be enumerated.
+template<>
+struct gdyn::enumerable<cheese_maze::Cell> {
+  static constexpr std::array values {cheese_maze::Cell::C1, cheese_maze::Cell::C2, cheese_maze::Cell::C3, cheese_maze::Cell::C4,
+				      cheese_maze::Cell::C5, cheese_maze::Cell::C6, cheese_maze::Cell::C7, cheese_maze::Cell::C8,
+				      cheese_maze::Cell::C9, cheese_maze::Cell::C10, cheese_maze::Cell::C11};
+};
+
+template<>
+struct gdyn::enumerable<cheese_maze::Dir> {
+  static constexpr std::array values {cheese_maze::Dir::Left, cheese_maze::Dir::Right, cheese_maze::Dir::Up, cheese_maze::Dir::Down};
+};
+
+template<>
+struct gdyn::enumerable<cheese_maze::Walls> {
+  static constexpr std::array values {cheese_maze::Walls::bLUr, cheese_maze::Walls::BlUr, cheese_maze::Walls::blUr,
+				      cheese_maze::Walls::blUR, cheese_maze::Walls::bLuR, cheese_maze::Walls::BLuR};
+};
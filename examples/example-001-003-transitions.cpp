@@ -59,6 +59,40 @@ int main(int argc, char* argv[]) {
 	: transitions_dataset
 	| std::views::filter([](auto t){return t.is_terminal();}))
     print_transition(t, step);
+
+  // A vector of transitions stores each observation twice (as
+  // observation and as next_observation of the previous
+  // transition). The episode store keeps each of them once, in
+  // columns that can be used directly for batch learning.
+  gdyn::store::episodes<Bonobo::observation_type, Bonobo::command_type, Bonobo::report_type> dataset;
+  for(unsigned int orbit = 0; orbit < NB_ORBITS; ++orbit) {
+    simulator = Bonobo::random_state(gen);
+    dataset.push_orbit(gdyn::views::pulse([&gen](){return Bonobo::random_command(gen);})
+		       | gdyn::views::orbit(simulator));
+  }
+  std::cout << std::endl
+	    << "The episode store holds " << dataset.size() << " transitions from " << dataset.nb_episodes() << " orbits." << std::endl
+	    << "  it takes " << dataset.memory_size() << " bytes, against "
+	    << dataset.size() * sizeof(gdyn::transition<Bonobo::observation_type, Bonobo::command_type, Bonobo::report_type>)
+	    << " for a vector of transitions." << std::endl
+	    << "  here is the last transition of the first orbit:" << std::endl;
+  step = 1;
+  for(auto t : dataset.episode(0) | std::views::filter([](auto t){return t.is_terminal();}))
+    print_transition(t, step);
+
+  // Multi-step targets are computed on the fly, from n-step
+  // transitions. Here, a report is the discounted sum of the 3 next
+  // rewards.
+  std::cout << std::endl
+	    << "3-step transitions at the end of an orbit:" << std::endl;
+  simulator = Bonobo::random_state(gen);
+  for(const auto& t
+	: gdyn::views::pulse([&gen](){return Bonobo::random_command(gen);})
+	| gdyn::views::orbit(simulator)
+	| gdyn::views::n_step_transition(3, .9)
+	| std::views::filter([](const auto& t){return t.is_terminal();}))
+    std::cout << "  " << t.observation << " --> " << t.command << " --> " << t.report
+	      << " in " << t.steps << " steps, " << t.next_observation << std::endl;
   
   return 0;
 }
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <random>
+#include <ranges>
+
+#include <gdyn.hpp>
+#include "bonobo-system.hpp"
+
+// When a terminal state is reached, views::episodes resets the
+// system and goes on with a new episode. The first command of the
+// new episode has to be decided from the new state, even when the
+// controller is wrapped in other views.
+
+#define NB_POINTS 100000
+
+// This controller spells BONOBO (the terminal word) in at most six
+// steps, since letters are pushed in front of the word: it finds the
+// longest front of the word that is an end of BONOBO, and pushes the
+// letter that precedes it.
+Bonobo::command_type control_policy(const Bonobo::observation_type& observation) {
+  const std::string target = "BONOBO";
+  std::size_t k = 5;
+  while(observation.compare(0, k, target, 6 - k) != 0) --k;
+  return static_cast<Bonobo::letter>(target[5 - k]);
+}
+
+// This counts the orbit points whose next command is not the one the
+// controller decides for their observation.
+template<typename ORBIT>
+void check(const std::string& name, ORBIT&& orbit) {
+  std::size_t nb_points = 0, nb_episodes = 0, nb_wrong = 0;
+  for(const auto& point : orbit) {
+    ++nb_points;
+    if(!point.previous_report) ++nb_episodes;
+    if(point.next_command && *(point.next_command) != control_policy(point.current_observation)) ++nb_wrong;
+  }
+  std::cout << name << " : " << nb_wrong << " wrong commands out of " << nb_points
+	    << " orbit points, in " << nb_episodes << " episodes." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  Bonobo simulator;
+  auto reset = [&gen](){return Bonobo::random_state(gen);};
+
+  check("controller                 ",
+	gdyn::views::controller(simulator, control_policy)
+	| gdyn::views::episodes(simulator, reset)
+	| std::views::take(NB_POINTS));
+
+  check("controller | take          ",
+	gdyn::views::controller(simulator, control_policy)
+	| std::views::take(NB_POINTS)
+	| gdyn::views::episodes(simulator, reset));
+
+  check("controller | transform     ",
+	gdyn::views::controller(simulator, control_policy)
+	| std::views::transform([](auto command) {return command;})
+	| gdyn::views::episodes(simulator, reset)
+	| std::views::take(NB_POINTS));
+
+  return 0;
+}
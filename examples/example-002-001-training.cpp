@@ -110,17 +110,22 @@ int main(int argc, char* argv[]) {
   adaptive_controller greedy_controller;
   
   double avg_orbit_length = 0;
-  while(true) {
-    unsigned int step = 0;
-    simulator = Bonobo::random_state(gen);
-    for([[maybe_unused]] auto& unused
-	  : gdyn::views::controller(simulator, epsilon_greedy(gen, .1, greedy_controller))                               // We use the controller to feed an orbit.
-	  | gdyn::views::orbit(simulator)                                                                                // This is the orbit.
-	  | gdyn::views::transition                                                                                      // We collect transitions.
-	  | std::views::filter([&greedy_controller](const auto& sample){greedy_controller.learn(sample); return true;})) // We use the transitions to update the controller.
-      ++step;
-    avg_orbit_length += .05 * (step - avg_orbit_length);
-    std::cout << "Average duration : " << std::setw(4) << (int)avg_orbit_length << " steps \r" << std::flush;
+  unsigned int step = 0;
+
+  // The pipeline is built once. The episodes view resets the
+  // simulator with a random state each time a terminal state is
+  // reached, so transitions flow endlessly, episode after episode.
+  for(auto& sample
+	: gdyn::views::controller(simulator, epsilon_greedy(gen, .1, greedy_controller))       // We use the controller to feed an orbit.
+	| gdyn::views::episodes(simulator, [&gen](){return Bonobo::random_state(gen);})        // These are successive orbits.
+	| gdyn::views::transition) {                                                           // We collect transitions.
+    greedy_controller.learn(sample); // We use the transitions to update the controller.
+    ++step;
+    if(sample.is_terminal()) { // The current episode is over.
+      avg_orbit_length += .05 * (step - avg_orbit_length);
+      std::cout << "Average duration : " << std::setw(4) << (int)avg_orbit_length << " steps \r" << std::flush;
+      step = 0;
+    }
     // This is not working well, this example is just given for illustration.
   }
   
@@ -41,6 +41,16 @@ int main(int argc, char* argv[]) {
 	| std::views::take(20))
     std::cout << command << std::endl;
 
+  // As cartpole commands are enumerable, the same can be done by
+  // blocks of commands drawn at once from a seeded random stream,
+  // which is much faster.
+  std::cout << std::endl;
+  std::cout << "Seeded random command source" << std::endl;
+  for(auto command
+	: gdyn::views::random_commands<gdyn::problem::cartpole::system>(rd())
+	| std::views::take(20))
+    std::cout << command << std::endl;
+
   // The command source can be obtained by a policy, i.e. a function
   // that chooses the command according to the system state.
   std::cout << std::endl;
@@ -71,7 +81,24 @@ int main(int argc, char* argv[]) {
 
   // What we have just done is running an orbit/trajectory of the dynamical system.
   // See example-001-001-orbit or example-004-000-cheesemaze
-  
+
+  // When the parameters are known at compiling time, they can be
+  // given as a template argument. The compiler can then fold all the
+  // constants into the transition computation.
+  std::cout << std::endl;
+  std::cout << "Compile-time parameters" << std::endl;
+  auto fast_simulator = gdyn::problem::cartpole::make_static<gdyn::problem::cartpole::parameters {.delta_time = .1}>();
+  static_assert(gdyn::concepts::system<decltype(fast_simulator)>);
+  fast_simulator = gdyn::problem::cartpole::random_state(gen, fast_simulator.param);
+  for(auto [observation, action, report]
+        : gdyn::views::controller(fast_simulator, policy)
+        | gdyn::views::orbit(fast_simulator)
+        | std::views::take(20)) {
+    std::cout << to_string(observation);
+    if (action) std::cout << " -> " << *action;
+    std::cout << std::endl;
+  }
+
   return 0;
   
 }
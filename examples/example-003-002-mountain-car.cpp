@@ -1,5 +1,6 @@
 #include <iostream>
 #include <random>
+#include <vector>
 
 #include <gdyn.hpp>
 
@@ -26,5 +27,23 @@ int main(int argc, char* argv[]) {
           std::cout << std::endl;
   }
 
+  // When many cars are to be simulated (e.g. for parameter sweeps),
+  // the batch engine steps all of them at once. Compile with
+  // vectorization enabled (e.g. -march=native) to get the best of
+  // it.
+  std::size_t nb_cars = 1000;
+  auto cars = gdyn::problem::mountain_car::make_batch(nb_cars, params);
+  for(std::size_t i = 0; i < nb_cars; ++i)
+    cars.set(i, gdyn::problem::mountain_car::random_state(gen, params));
+  std::vector<gdyn::problem::mountain_car::acceleration> commands(nb_cars);
+  for(unsigned int step = 0; step < 1000; ++step) {
+    for(auto& command : commands) command = gdyn::problem::mountain_car::random_command(gen);
+    cars(commands);
+  }
+  std::size_t nb_arrived = 0;
+  for(auto terminal : cars.terminals()) nb_arrived += terminal;
+  std::cout << std::endl
+	    << nb_arrived << " cars out of " << nb_cars << " are at the goal after 1000 random steps." << std::endl;
+
   return 0;
 }
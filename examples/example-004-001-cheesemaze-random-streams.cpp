@@ -0,0 +1,63 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "cheesemaze-system.hpp"
+
+// The cheese maze is stochastic. Here, each orbit draws its random
+// values from its own counter-based stream, addressed by (seed,
+// orbit index). The orbits are thus the same, whatever the thread
+// they are computed in and the order they are computed in.
+
+#define SEED      12345
+#define NB_ORBITS 8
+#define NB_THREADS 4
+
+// This computes an orbit, and returns a text describing it.
+std::string orbit(std::uint64_t orbit_index) {
+  gdyn::random::stream gen(SEED, orbit_index);
+  cheese_maze::Parameters param; // mishap_proba is not 0, the system is stochastic.
+  auto simulator = cheese_maze::make_environment(param, gen);
+  simulator = cheese_maze::random_state(gen);
+
+  std::string res;
+  for(auto [observation, command, report]
+	: gdyn::views::pulse([&gen](){return cheese_maze::random_command(gen);})
+	| gdyn::views::orbit(simulator)
+	| std::views::take(20)) {
+    res += cheese_maze::to_string(observation);
+    if(command) {
+      res += ' ';
+      res += cheese_maze::to_string(*command);
+      res += ' ';
+    }
+  }
+  return res;
+}
+
+int main(int argc, char *argv[]) {
+
+  // Orbits are computed sequentially...
+  std::vector<std::string> sequential;
+  for(std::uint64_t o = 0; o < NB_ORBITS; ++o)
+    sequential.push_back(orbit(o));
+
+  // ... and by several threads, each computing the orbits in reverse order.
+  std::vector<std::string> parallel(NB_ORBITS);
+  {
+    std::vector<std::jthread> threads;
+    for(unsigned int t = 0; t < NB_THREADS; ++t)
+      threads.emplace_back([t, &parallel]() {
+	for(std::uint64_t o = NB_ORBITS; o-- > 0;)
+	  if(o % NB_THREADS == t) parallel[o] = orbit(o);
+      });
+  }
+
+  for(std::uint64_t o = 0; o < NB_ORBITS; ++o)
+    std::cout << "orbit " << o << " : " << (sequential[o] == parallel[o] ? "same" : "DIFFERENT") << std::endl
+	      << "  " << sequential[o] << std::endl;
+  
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+#include "cheesemaze-system.hpp"
+
+// The cheese maze is partially observable: several cells show the
+// same walls. Let us measure how much the histories of the last k
+// orbit points disambiguate the cells. The histories are spans of a
+// ring buffer, that are used directly to search a table whose keys
+// are vectors of orbit points.
+
+#define NB_POINTS 1000000
+#define MAX_K     5
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto simulator = cheese_maze::make_environment(cheese_maze::Parameters(), gen);
+  using maze = decltype(simulator);
+
+  for(std::size_t k = 1; k <= MAX_K; ++k) {
+    auto histories = gdyn::views::random_commands<maze>(rd())
+      | gdyn::views::episodes(simulator, [&gen](){return cheese_maze::random_state(gen);})
+      | std::views::take(NB_POINTS)
+      | gdyn::views::history(k);
+    using point = typename std::ranges::range_value_t<decltype(histories)>::value_type;
+    using cells = std::array<std::size_t, gdyn::cardinal<cheese_maze::Cell>>;
+    std::unordered_map<std::vector<point>, cells, gdyn::history_hash, gdyn::history_equal> table;
+
+    // For each history, we count the cells where the simulator is
+    // (the state of the last point).
+    for(auto history : histories) {
+      auto it = table.find(history);
+      if(it == table.end()) it = table.emplace(std::vector<point>(history.begin(), history.end()), cells {}).first;
+      ++(it->second[gdyn::index_of(simulator.state())]);
+    }
+
+    // A history is ambiguous when it is met in several cells. The
+    // best guess is then the most frequent cell.
+    std::size_t nb_wrong_guesses = 0;
+    for(const auto& [history, counts] : table) {
+      std::size_t total = 0, best = 0;
+      for(auto c : counts) {total += c; best = std::max(best, c);}
+      nb_wrong_guesses += total - best;
+    }
+    std::cout << "k = " << k << " : " << table.size() << " distinct histories, the cell is wrongly guessed from the history "
+	      << 100. * nb_wrong_guesses / NB_POINTS << "% of the time." << std::endl;
+  }
+  
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <optional>
+
+#include "cheesemaze-system.hpp"
+
+// The cheese maze is partially observable, but its dynamics is
+// known. Let us wrap it so that its observation is the exact belief
+// over the cells, and drive it from the belief. Then, the beliefs of
+// many agents are filtered at once. Last, the exact belief is
+// compared to the one approximated by a particle filter.
+
+#define NB_STEPS    100000
+#define NB_TESTS    10000
+#define MAX_LENGTH  100
+#define GAMMA       .95
+#define NB_AGENTS   10000
+#define NB_TICKS    100
+#define NB_PARTICLES 1000
+
+using namespace cheese_maze;
+
+// This is the index of the most likely cell.
+int most_likely(const Belief& belief) {
+  return static_cast<int>(std::max_element(belief.begin(), belief.end()) - belief.begin());
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto maze = make_environment(Parameters(), gen);
+  auto simulator = make_belief_environment(maze);
+  static_assert(gdyn::concepts::transparent_system<decltype(simulator)>);
+  BeliefModel model(maze);
+
+  // How often is the most likely cell the actual one ?
+  std::size_t nb_right = 0;
+  for(const auto& point : gdyn::views::random_commands<decltype(simulator)>(rd())
+	| gdyn::views::episodes(simulator, [&gen](){return random_state(gen);})
+	| std::views::take(NB_STEPS))
+    nb_right += (most_likely(point.current_observation) == static_cast<int>(simulator.state()));
+  std::cout << "The most likely cell is the actual one " << 100. * nb_right / NB_STEPS << "% of the time." << std::endl;
+
+  // The Q values of the underlying (fully observable) problem are
+  // computed by value iteration. The QMDP controller weights them by
+  // the belief.
+  std::array<std::array<double, nbDir>, nbCell> q {};
+  for(unsigned int it = 0; it < 1000; ++it) {
+    std::array<double, nbCell> v {};
+    for(int s = 0; s < nbCell; ++s)
+      if(static_cast<Cell>(s) != Cell::C10) v[s] = *std::max_element(q[s].begin(), q[s].end());
+    for(int s = 0; s < nbCell; ++s)
+      for(int a = 0; a < nbDir; ++a) {
+	q[s][a] = 0;
+	for(int next = 0; next < nbCell; ++next) {
+	  double reward = (static_cast<Cell>(next) == Cell::C10 ? 5 : 0) - (next == s ? 1 : 0);
+	  q[s][a] += model(static_cast<Cell>(s), static_cast<Dir>(a), static_cast<Cell>(next)) * (reward + GAMMA * v[next]);
+	}
+      }
+  }
+  auto qmdp = [&q](const Belief& belief) {
+    std::array<double, nbDir> values {};
+    for(int s = 0; s < nbCell; ++s)
+      for(int a = 0; a < nbDir; ++a) values[a] += belief[s] * q[s][a];
+    return static_cast<Dir>(std::max_element(values.begin(), values.end()) - values.begin());
+  };
+  auto random = [&gen](const Belief&) {return random_command(gen);};
+
+  auto length = [&](const auto& controller) {
+    double res = 0;
+    for(unsigned int t = 0; t < NB_TESTS; ++t) {
+      simulator = random_state(gen);
+      res += std::ranges::distance(gdyn::views::controller(simulator, controller)
+				   | gdyn::views::orbit(simulator)
+				   | std::views::take(MAX_LENGTH));
+    }
+    return res / NB_TESTS;
+  };
+  std::cout << "Average episode length (at most " << MAX_LENGTH << "): "
+	    << length(random) << " for random commands, " << length(qmdp) << " for the QMDP controller." << std::endl;
+
+  // Let us now filter the beliefs of many agents at once.
+  std::vector<Environment<std::mt19937>> mazes(NB_AGENTS, maze);
+  BeliefBatch beliefs(model, NB_AGENTS);
+  std::vector<Dir> commands(NB_AGENTS);
+  std::vector<Walls> observations(NB_AGENTS);
+  std::vector<unsigned char> terminals(NB_AGENTS);
+  for(std::size_t i = 0; i < NB_AGENTS; ++i) {
+    mazes[i] = random_state(gen);
+    beliefs.set(i, *mazes[i], !mazes[i]);
+  }
+  std::chrono::duration<double> elapsed {0};
+  nb_right = 0;
+  for(unsigned int tick = 0; tick < NB_TICKS; ++tick) {
+    for(std::size_t i = 0; i < NB_AGENTS; ++i) {
+      if(!mazes[i]) { // The agent has reached the cheese, it restarts.
+	mazes[i] = random_state(gen);
+	beliefs.set(i, *mazes[i], !mazes[i]);
+      }
+      commands[i] = random_command(gen);
+      mazes[i](commands[i]);
+      observations[i] = *mazes[i];
+      terminals[i] = !mazes[i];
+    }
+    auto start = std::chrono::steady_clock::now();
+    beliefs(commands, observations, terminals);
+    elapsed += std::chrono::steady_clock::now() - start;
+    for(std::size_t i = 0; i < NB_AGENTS; ++i) {
+      auto b = beliefs[i];
+      nb_right += (std::max_element(b.begin(), b.end()) - b.begin()) == static_cast<int>(mazes[i].state());
+    }
+  }
+  std::cout << NB_AGENTS << " agents: " << NB_AGENTS * NB_TICKS / elapsed.count() << " belief updates per second, the most likely cell is the actual one "
+	    << 100. * nb_right / (NB_AGENTS * NB_TICKS) << "% of the time." << std::endl;
+
+  // The particle filter only knows the walls and whether the maze is
+  // in its terminal cell, as the exact belief, that is updated along.
+  auto particle_filter = gdyn::system::make_particle_filter(maze, Particles(maze, NB_PARTICLES), rd());
+  double distance = 0;
+  std::size_t nb_points = 0;
+  for(unsigned int t = 0; t < NB_TESTS / 10; ++t) {
+    particle_filter = random_state(gen);
+    Belief exact = model.prior(*maze, !maze);
+    std::optional<Dir> command;
+    for(const auto& point : gdyn::views::random_commands<decltype(particle_filter)>(rd())
+	  | gdyn::views::orbit(particle_filter)
+	  | std::views::take(MAX_LENGTH)) {
+      if(command) exact = model.update(exact, *command, *maze, !maze);
+      for(int s = 0; s < nbCell; ++s) distance += .5 * std::abs(point.current_observation[s] - exact[s]);
+      ++nb_points;
+      command = point.next_command;
+    }
+  }
+  std::cout << "With " << NB_PARTICLES << " particles, the total variation distance to the exact belief is "
+	    << distance / nb_points << " on average." << std::endl;
+  
+  return 0;
+}
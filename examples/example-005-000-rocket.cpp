@@ -29,6 +29,7 @@ int main(int argc, char* argv[]) {
       std::ostringstream filename;
       filename << "rocket-" << mode << "-" << int(1000*dt) << "ms.dat";
       std::ofstream datafile {filename.str()};
+      gdyn::text::writer data {datafile};
       up.duration = dt;
       none.duration = dt;
       double t = 0;
@@ -36,7 +37,7 @@ int main(int argc, char* argv[]) {
       for(auto [observation, action, report]
 	    : gdyn::views::pulse([&up, &none, &t](){if(t < END_OF_THRUST - .01) return up; else return none;})
 	    | gdyn::views::orbit(rocket)) {
-	datafile << t << ' ' << observation.height << ' ' << observation.speed << std::endl;
+	data.row(t, observation); // This writes t, height and speed.
 	t += dt;
       }
       std::cout << "Generating " << filename.str() << std::endl;
@@ -31,6 +31,8 @@ int main(int argc, char* argv[]) {
     std::ofstream datafile {filename};
     std::string targetname {"target.dat"};
     std::ofstream datatarget {targetname};
+    gdyn::text::writer data {datafile};
+    gdyn::text::writer target_data {datatarget};
     t = 0;
     relative_rocket = {.error = 10, .speed = 0};
     for(auto [observation, action, report]
@@ -41,11 +43,8 @@ int main(int argc, char* argv[]) {
       // We get orbits of rocket, while controlling relative_rocket. So
       // we have access to height and speed, while relative rocket
       // observations are only the current error.
-      if(action)
-	datafile << t << ' ' << observation.height << ' ' << observation.speed << ' ' << action->value << std::endl;
-      else
-	datafile << t << ' ' << observation.height << ' ' << observation.speed << ' ' <<             0 << std::endl;
-      datatarget << t << ' ' << target << std::endl;
+      data.row(t, observation, action ? action->value : 0.);
+      target_data.row(t, target);
       t += DT;
       if(t > 35) target = 30; // We change the target.
       if(t > 60) target = 50; // We change the target.
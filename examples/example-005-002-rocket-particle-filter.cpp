@@ -0,0 +1,63 @@
+#include <iostream>
+#include <random>
+#include <cmath>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// The relative rocket only observes its error, i.e. the difference
+// between its height and the target. Its speed is hidden. Let us
+// estimate the whole phase with a particle filter, and use the
+// estimated speed for damping the control.
+
+#define DT           .1
+#define NB_STEPS     1000
+#define NB_PARTICLES 10000
+#define TARGET       50
+#define DAMPING      1.
+
+using namespace gdyn::problem;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+
+  rocket::parameters params;
+  params.drag_coef = .1;
+  rocket::thrust up   {.value = 20, .duration = DT};
+  rocket::thrust none {.value =  0, .duration = DT};
+  auto base = rocket::system(params);
+  auto relative_rocket = rocket::relative::system(base, [](){return TARGET;});
+
+  // The particles draw their initial speed in [-5, 5], the thrust
+  // noise is 1N and the observation noise .1m.
+  rocket::relative::particles particles(params, NB_PARTICLES, 5, 1, .1);
+  auto filtered_rocket = gdyn::system::make_particle_filter(relative_rocket, particles, rd());
+  static_assert(gdyn::concepts::system<decltype(filtered_rocket)>);
+
+  // The rough controller only uses the error, the damped one uses the
+  // estimated speed as well.
+  auto rough  = [up, none](const rocket::relative::phase& estimate) {return estimate.error < 0 ? up : none;};
+  auto damped = [up, none](const rocket::relative::phase& estimate) {return estimate.error + DAMPING * estimate.speed < 0 ? up : none;};
+
+  auto run = [&](const std::string& name, const auto& controller) {
+    filtered_rocket = rocket::relative::phase {.error = 10, .speed = 0};
+    double error = 0, speed_error = 0;
+    unsigned int step = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(const auto& point : gdyn::views::controller(filtered_rocket, controller)
+	  | gdyn::views::orbit(filtered_rocket)
+	  | std::views::take(NB_STEPS)) {
+      double actual_speed = relative_rocket.state().speed;
+      speed_error += std::pow(point.current_observation.speed - actual_speed, 2);
+      if(step++ >= NB_STEPS / 2) error += std::abs(*relative_rocket); // The second half, once stabilized.
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": mean |error| = " << error / (step - NB_STEPS / 2)
+	      << "m, speed estimation RMS error = " << std::sqrt(speed_error / step) << "m/s ("
+	      << elapsed.count() / step * 1e3 << "ms per step with " << NB_PARTICLES << " particles)." << std::endl;
+  };
+  run("Rough controller ", rough);
+  run("Damped controller", damped);
+  
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <array>
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+
+#include <gdyn.hpp>
+#include "bonobo-system.hpp"
+
+// Here, several actor threads simulate the Bonobo system, while a
+// single learner thread (the main one here) consumes the resulting
+// transitions. Transitions are sent to the learner through a
+// lock-free queue. The learner regularly broadcasts its current
+// controller to the actors, without any lock.
+
+using transition = gdyn::transition<Bonobo::observation_type, Bonobo::command_type, Bonobo::report_type>;
+
+#define NB_ACTORS          4
+#define QUEUE_CAPACITY 65536
+#define BATCH_SIZE       256
+#define NB_TRANSITIONS 10000000
+#define BROADCAST_PERIOD 1000 // in batches
+
+// This is what the learner computes: the average reward for each
+// (observation, command) pair. This is also a greedy controller.
+struct reward_table {
+  std::map<std::string, std::array<double, 3>> reward_average;
+
+  void learn(const transition& sample) {
+    auto& w = reward_average[sample.observation][static_cast<std::size_t>(sample.command == Bonobo::letter::O) + 2 * static_cast<std::size_t>(sample.command == Bonobo::letter::N)];
+    w += .1 * (sample.report - w);
+  }
+
+  Bonobo::command_type operator()(const Bonobo::observation_type& observation) const {
+    if(auto it = reward_average.find(observation); it != reward_average.end()) {
+      const auto& values = it->second;
+      switch(std::distance(values.begin(), std::max_element(values.begin(), values.end()))) {
+      case 0 : return Bonobo::letter::B;
+      case 1 : return Bonobo::letter::O;
+      default: return Bonobo::letter::N;
+      }
+    }
+    return Bonobo::letter::B;
+  }
+};
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  gdyn::parallel::mpsc_queue<transition> queue(QUEUE_CAPACITY);
+
+  // This is where the learner publishes its controller.
+  reward_table table;
+  gdyn::parallel::versioned<reward_table> broadcast(table, NB_ACTORS);
+
+  // Each actor runs its own pipeline, with its own system and its
+  // own random generator. The std::jthread destructor requests the
+  // actor to stop and waits for it.
+  std::vector<std::jthread> actors;
+  for(unsigned int a = 0; a < NB_ACTORS; ++a)
+    actors.emplace_back([&queue, reader = broadcast.make_reader(), seed = rd()](std::stop_token stop) {
+      std::mt19937 gen(seed);
+      Bonobo simulator;
+      // The reader is a controller, that uses the last published
+      // table. It cannot be copied, so it is referred to.
+      auto epsilon_greedy = [&gen, &reader](const Bonobo::observation_type& observation) {
+	if(std::bernoulli_distribution(.1)(gen)) return Bonobo::random_command(gen);
+	return reader(observation);
+      };
+      gdyn::parallel::feed(queue,
+			   gdyn::views::controller(simulator, epsilon_greedy)
+			   | gdyn::views::episodes(simulator, [&gen](){return Bonobo::random_state(gen);})
+			   | gdyn::views::transition,
+			   stop);
+    });
+
+  // The learner drains the queue by batches.
+  std::vector<transition> batch(BATCH_SIZE);
+  std::size_t nb_transitions = 0;
+  std::size_t nb_terminals   = 0;
+  std::size_t nb_batches     = 0;
+  auto start = std::chrono::steady_clock::now();
+  while(nb_transitions < NB_TRANSITIONS) {
+    auto nb = queue.pop(batch.begin(), batch.size());
+    if(nb == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    for(auto it = batch.begin(); it != batch.begin() + nb; ++it) {
+      table.learn(*it);
+      nb_terminals += it->is_terminal();
+    }
+    nb_transitions += nb;
+    if(++nb_batches % BROADCAST_PERIOD == 0)
+      broadcast.publish(table);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  actors.clear(); // This stops the actors.
+
+  std::cout << nb_transitions << " transitions (" << nb_terminals << " episodes) learnt in "
+	    << elapsed.count() << "s from " << NB_ACTORS << " actors." << std::endl
+	    << table.reward_average.size() << " observations have been visited, "
+	    << broadcast.version() << " versions of the controller have been broadcast." << std::endl;
+  
+  return 0;
+}
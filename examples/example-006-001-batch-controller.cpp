@@ -0,0 +1,101 @@
+#include <array>
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+
+#include <gdyn.hpp>
+
+// Some controllers are more efficient when they compute many commands
+// at once. Here, many cartpoles are driven by a single linear
+// controller, which is called once per tick for all of them.
+
+using cartpole = gdyn::problem::cartpole::system;
+
+#define NB_CARTPOLES 1000
+#define LANE         10
+
+// This is a batch controller. It computes the commands for a span of
+// observations, and returns them in a buffer it owns.
+struct linear_controller {
+  std::array<double, 4> weights {.0, .1, 1., .5};
+  std::vector<cartpole::command_type> commands;
+
+  std::span<const cartpole::command_type> operator()(std::span<const cartpole::observation_type> observations) {
+    commands.resize(observations.size());
+    auto out = commands.begin();
+    for(const auto& obs : observations)
+      *(out++) = (weights[0] * obs.x + weights[1] * obs.x_dot + weights[2] * obs.theta + weights[3] * obs.theta_dot > 0)
+	? gdyn::problem::cartpole::direction::Right
+	: gdyn::problem::cartpole::direction::Left;
+    return commands;
+  }
+};
+
+// Let us check that our controller satisfies the appropriate concept.
+static_assert(gdyn::concepts::batch_controller<linear_controller,
+	      cartpole::observation_type, cartpole::command_type>);
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  linear_controller controller;
+  std::vector<cartpole> cartpoles(NB_CARTPOLES, gdyn::problem::cartpole::make());
+
+  // Each tick provides the current orbit point of every cartpole
+  // which is still running.
+  for(auto& c : cartpoles) c = gdyn::problem::cartpole::random_state(gen, c.param);
+  unsigned int tick = 0;
+  for(auto points : gdyn::views::batch_orbit(cartpoles, controller)) {
+    if(tick % 100 == 0)
+      std::cout << "tick " << std::setw(5) << tick << " : " << std::setw(5) << points.size() << " cartpoles are running." << std::endl;
+    ++tick;
+    if(tick == 1000) break;
+  }
+  std::cout << std::endl;
+
+  // Transitions can be collected as well, tick after tick.
+  for(auto& c : cartpoles) c = gdyn::problem::cartpole::random_state(gen, c.param);
+  std::size_t nb_transitions = 0;
+  std::size_t nb_terminals   = 0;
+  for(auto transitions
+	: gdyn::views::batch_orbit(cartpoles, controller)
+	| gdyn::views::batch_transition
+	| std::views::take(1000))
+    for(const auto& transition : transitions) {
+      ++nb_transitions;
+      nb_terminals += transition.is_terminal();
+    }
+  std::cout << nb_transitions << " transitions collected, " << nb_terminals << " cartpoles have fallen." << std::endl;
+
+  // The orbit of a single lane can be used as any other orbit. Let us
+  // check that it is the orbit its cartpole would have alone, driven
+  // by the same controller.
+  for(auto& c : cartpoles) c = gdyn::problem::cartpole::random_state(gen, c.param);
+  auto alone = cartpoles[LANE];
+  linear_controller single;
+  std::vector<gdyn::transition<cartpole::observation_type, cartpole::command_type, cartpole::report_type>> expected;
+  for(const auto& transition
+	: gdyn::views::controller(alone, [&single](const cartpole::observation_type& observation) {return single(std::span(&observation, 1))[0];})
+	| gdyn::views::orbit(alone)
+	| std::views::take(1000)
+	| gdyn::views::transition)
+    expected.push_back(transition);
+  std::size_t nb_same = 0, rank = 0;
+  for(const auto& transition
+	: gdyn::views::batch_orbit(cartpoles, controller)
+	| gdyn::views::lane(LANE)
+	| std::views::take(1000)
+	| gdyn::views::transition) {
+    if(rank < expected.size()
+       && transition.observation.x == expected[rank].observation.x && transition.observation.theta == expected[rank].observation.theta
+       && transition.command == expected[rank].command && transition.report == expected[rank].report)
+      ++nb_same;
+    ++rank;
+  }
+  std::cout << "Lane " << LANE << " : " << nb_same << " transitions out of " << expected.size() << " are the ones of the cartpole alone." << std::endl;
+  
+  return 0;
+}
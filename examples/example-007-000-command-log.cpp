@@ -0,0 +1,72 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <atomic>
+
+#include <gdyn.hpp>
+
+// The mountain car is deterministic. Its episodes can thus be stored
+// as command logs, and recomputed when they are needed.
+
+#define NB_EPISODES 100
+#define MAX_LENGTH  1000
+
+using car = gdyn::problem::mountain_car::system;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::mountain_car::make();
+
+  // We record episodes made of random commands, and we keep the last
+  // observation of each one for further checking.
+  std::vector<gdyn::log::episode<car>> logs;
+  std::vector<car::observation_type> finals;
+  std::size_t nb_points = 0;
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    logs.push_back(gdyn::log::record(simulator,
+				     gdyn::problem::mountain_car::random_state(gen, simulator.param),
+				     gdyn::views::random_commands<car>(rd(), e) | std::views::take(MAX_LENGTH)));
+    finals.push_back(*simulator);
+    nb_points += logs.back().size() + 1;
+  }
+
+  std::size_t log_size = 0;
+  for(const auto& log : logs) log_size += log.memory_size();
+  std::size_t transition_size = nb_points * sizeof(gdyn::transition<car::observation_type, car::command_type, car::report_type>);
+  std::cout << "Storing " << nb_points << " orbit points takes" << std::endl
+	    << "  " << transition_size << " bytes as transitions," << std::endl
+	    << "  " << log_size << " bytes as command logs." << std::endl;
+
+  // Logs can be archived...
+  std::stringstream archive;
+  for(const auto& log : logs) log.write(archive);
+  std::vector<gdyn::log::episode<car>> restored(NB_EPISODES);
+  for(auto& log : restored) log.read(archive);
+
+  // ... and replayed, here in parallel. The simulator is
+  // deterministic, so each replay runs on a copy of it, and the
+  // random stream is ignored.
+  std::atomic<std::size_t> nb_same {0};
+  gdyn::log::replay([&simulator](gdyn::random::stream&) {return simulator;}, restored,
+		    [&finals, &nb_same](std::size_t i, auto&& orbit) {
+		      car::observation_type last {};
+		      for(const auto& point : orbit) last = point.current_observation;
+		      if(last.position == finals[i].position && last.velocity == finals[i].velocity) ++nb_same;
+		    });
+  std::cout << nb_same << " replayed episodes out of " << NB_EPISODES << " end as recorded." << std::endl;
+
+  // A single episode can be replayed as any other orbit.
+  std::cout << std::endl << "First steps of the first episode:" << std::endl;
+  for(auto [observation, command, report]
+	: gdyn::log::replay(simulator, restored.front())
+	| std::views::take(5)) {
+    std::cout << "  " << observation;
+    if(command) std::cout << " -> " << *command;
+    std::cout << std::endl;
+  }
+  
+  return 0;
+}
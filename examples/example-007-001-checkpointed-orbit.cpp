@@ -0,0 +1,71 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <gdyn.hpp>
+#include "cheesemaze-system.hpp"
+
+// Let us compute the discounted return of each point of a very long
+// cartpole orbit. This requires to read the orbit backwards. The
+// orbit is stored with checkpoints, its points are recomputed
+// segment by segment during the backward reading.
+
+#define LENGTH 1000000
+#define GAMMA  .99
+
+using cartpole = gdyn::problem::cartpole::system;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::cartpole::make();
+  static_assert(gdyn::concepts::transparent_system<decltype(simulator)>);
+
+  // This controller keeps the pole up for a long time.
+  auto policy = [](const cartpole::observation_type& obs) {
+    if(obs.theta + .5 * obs.theta_dot + .05 * obs.x + .1 * obs.x_dot > 0) return gdyn::problem::cartpole::direction::Right;
+    else                                                                  return gdyn::problem::cartpole::direction::Left;
+  };
+
+  gdyn::store::checkpointed<cartpole> orbit(simulator, gdyn::store::checkpointed<cartpole>::period_for(LENGTH));
+  simulator = gdyn::problem::cartpole::random_state(gen, simulator.param);
+  for(const auto& point
+	: gdyn::views::controller(simulator, policy)
+	| gdyn::views::orbit(simulator)
+	| std::views::take(LENGTH))
+    orbit.push_back(simulator.state(), point);
+
+  std::cout << "The orbit has " << orbit.size() << " points." << std::endl
+	    << "  storing them would take " << orbit.size() * sizeof(gdyn::store::point<cartpole>) << " bytes," << std::endl
+	    << "  the checkpointed orbit takes " << orbit.memory_size() << " bytes." << std::endl;
+
+  // The return of a point is the discounted sum of the rewards that follow it.
+  double ret = 0;
+  for(const auto& point : orbit.reversed())
+    if(point.previous_report) ret = *(point.previous_report) + GAMMA * ret;
+  std::cout << "The return of the first transition is " << ret << "." << std::endl;
+
+  // Points can also be accessed directly.
+  std::cout << "Point " << orbit.size() / 2 << " is " << to_string(orbit[orbit.size() / 2].current_observation) << std::endl;
+
+  // Recomputing the points is only correct for deterministic
+  // systems. The cheese maze draws its mishaps from a generator that
+  // is not part of its state, so its orbits cannot be recomputed. As
+  // its states can be compared, this is detected when the orbit is
+  // read backwards.
+  auto maze = cheese_maze::make_environment(cheese_maze::Parameters(), gen);
+  using maze_type = decltype(maze);
+  std::size_t nb_detected = 0;
+  for(unsigned int o = 0; o < 100; ++o) {
+    gdyn::store::checkpointed<maze_type> maze_orbit(maze, 2);
+    maze_orbit.record(cheese_maze::Cell::C1, gdyn::views::random_commands<maze_type>(rd(), o) | std::views::take(100));
+    try {
+      for([[maybe_unused]] const auto& point : maze_orbit.reversed());
+    }
+    catch(const std::runtime_error&) {++nb_detected;}
+  }
+  std::cout << nb_detected << " cheese maze orbits out of 100 are detected as not recomputable." << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <gdyn.hpp>
+
+// Let us archive mountain car episodes, compressing each column of
+// the dataset with a codec.
+
+#define NB_EPISODES 100
+#define MAX_LENGTH  1000
+
+using car = gdyn::problem::mountain_car::system;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::mountain_car::make();
+  gdyn::store::episodes<car::observation_type, car::command_type, car::report_type> dataset;
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, simulator.param);
+    dataset.push_orbit(gdyn::views::random_commands<car>(rd(), e)
+		       | std::views::take(MAX_LENGTH)
+		       | gdyn::views::orbit(simulator));
+  }
+
+  // Let us split the observations into columns of doubles.
+  std::vector<double> positions, velocities;
+  for(const auto& obs : dataset.observations()) {
+    positions.push_back(obs.position);
+    velocities.push_back(obs.velocity);
+  }
+  
+  std::size_t raw_size = dataset.observations().size_bytes() + dataset.commands().size_bytes();
+  std::cout << "The dataset has " << dataset.size() << " transitions, its observations and commands take " << raw_size << " bytes." << std::endl;
+
+  // Lossless compression.
+  gdyn::codec::column<gdyn::codec::xor_double> lossless_positions(gdyn::codec::xor_double{});
+  gdyn::codec::column<gdyn::codec::xor_double> lossless_velocities(gdyn::codec::xor_double{});
+  gdyn::codec::column<gdyn::codec::packed<car::command_type>> commands(gdyn::codec::packed<car::command_type>{});
+  lossless_positions.encode(positions);
+  lossless_velocities.encode(velocities);
+  commands.encode(dataset.commands());
+  std::cout << "  lossless : "
+	    << lossless_positions.memory_size() + lossless_velocities.memory_size() + commands.memory_size() << " bytes" << std::endl;
+
+  // Lossy compression, with a bounded error.
+  gdyn::codec::column<gdyn::codec::quantized> lossy_positions(gdyn::codec::quantized(1e-4));
+  gdyn::codec::column<gdyn::codec::quantized> lossy_velocities(gdyn::codec::quantized(1e-6));
+  lossy_positions.encode(positions);
+  lossy_velocities.encode(velocities);
+  std::cout << "  lossy    : "
+	    << lossy_positions.memory_size() + lossy_velocities.memory_size() + commands.memory_size() << " bytes" << std::endl;
+
+  // Blocks are decoded in parallel.
+  auto decoded_positions  = lossless_positions.decode();
+  auto approx_positions   = lossy_positions.decode();
+  auto decoded_commands   = commands.decode();
+  double max_error = 0;
+  for(std::size_t i = 0; i < positions.size(); ++i)
+    max_error = std::max(max_error, std::fabs(approx_positions[i] - positions[i]));
+  std::cout << std::endl
+	    << "Lossless positions are " << (decoded_positions == positions ? "the same" : "DIFFERENT") << '.' << std::endl
+	    << "Commands are " << (std::ranges::equal(decoded_commands, dataset.commands()) ? "the same" : "DIFFERENT") << '.' << std::endl
+	    << "Lossy positions differ by " << max_error << " at most." << std::endl;
+
+  // Columns are archived, and a single value can be read by decoding its block only.
+  std::stringstream archive;
+  lossless_velocities.write(archive);
+  gdyn::codec::column<gdyn::codec::xor_double> restored(gdyn::codec::xor_double{});
+  restored.read(archive);
+  std::size_t i = velocities.size() / 3;
+  std::cout << "Velocity " << i << " is " << velocities[i] << ", it is restored as " << restored[i] << '.' << std::endl;
+  
+  return 0;
+}
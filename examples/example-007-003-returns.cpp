@@ -0,0 +1,87 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us compute the returns of the transitions of a mountain car
+// dataset. The computation runs in parallel over the episodes, and
+// over the chunks of long episodes.
+
+#define NB_EPISODES 1000
+#define MAX_LENGTH  10000
+#define GAMMA       .99
+#define LAMBDA      .9
+
+using car = gdyn::problem::mountain_car::system;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::mountain_car::make();
+  gdyn::store::episodes<car::observation_type, car::command_type, car::report_type> dataset;
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, simulator.param);
+    // The orbit points are truncated, rather than the commands, so
+    // that the last point keeps its pending command. Otherwise, every
+    // episode would be stored as terminated.
+    dataset.push_orbit(gdyn::views::random_commands<car>(rd(), e)
+		       | gdyn::views::orbit(simulator)
+		       | std::views::take(MAX_LENGTH + 1));
+  }
+  std::size_t nb_terminated = 0;
+  for(std::size_t e = 0; e < dataset.nb_episodes(); ++e) if(dataset.terminated(e)) ++nb_terminated;
+  std::cout << "The dataset has " << dataset.size() << " transitions, " << nb_terminated << " episodes out of "
+	    << dataset.nb_episodes() << " have reached the goal." << std::endl;
+
+  // This is the usual backward loop.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<double> sequential(dataset.size());
+  for(std::size_t e = 0; e < dataset.nb_episodes(); ++e) {
+    double ret = 0;
+    for(std::size_t t = dataset.offset(e + 1); t-- > dataset.offset(e);)
+      sequential[t] = ret = dataset.reports()[t] + GAMMA * ret;
+  }
+  std::chrono::duration<double> sequential_time = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  std::vector<double> returns(dataset.size());
+  gdyn::returns::discounted(dataset, GAMMA, returns);
+  std::chrono::duration<double> parallel_time = std::chrono::steady_clock::now() - start;
+
+  double max_diff = 0;
+  for(std::size_t t = 0; t < returns.size(); ++t) max_diff = std::max(max_diff, std::fabs(returns[t] - sequential[t]));
+  std::cout << "Discounted returns computed in " << parallel_time.count() << "s (" << sequential_time.count()
+	    << "s sequentially), max difference " << max_diff << '.' << std::endl;
+
+  // With a value estimation (here, a rough one), the returns of
+  // truncated episodes are bootstrapped by the value of their last
+  // observation, and TD(lambda) returns and advantages can be
+  // computed.
+  std::vector<double> values;
+  for(const auto& obs : dataset.observations()) values.push_back(-100 * (.6 - obs.position));
+  std::vector<double> bootstrapped(dataset.size());
+  gdyn::returns::discounted(dataset, values, GAMMA, bootstrapped);
+  max_diff = 0;
+  std::size_t nb_truncated = 0;
+  for(std::size_t e = 0; e < dataset.nb_episodes(); ++e) {
+    std::size_t last = dataset.offset(e + 1);
+    if(dataset.terminated(e) || last == dataset.offset(e)) continue;
+    ++nb_truncated;
+    // The last observation of episode e is at last + e.
+    double expected = dataset.reports()[last - 1] + GAMMA * values[last + e];
+    max_diff = std::max(max_diff, std::fabs(bootstrapped[last - 1] - expected));
+  }
+  std::cout << "Bootstrapped returns of the " << nb_truncated << " truncated episodes: max difference to r + gamma * V(s_T) "
+	    << max_diff << '.' << std::endl;
+  std::vector<double> td(dataset.size()), advantages(dataset.size());
+  gdyn::returns::td_lambda(dataset, values, GAMMA, LAMBDA, td);
+  gdyn::returns::gae(dataset, values, GAMMA, LAMBDA, advantages);
+  std::cout << "First transition: TD(lambda) return " << td[0] << ", advantage " << advantages[0] << '.' << std::endl;
+  
+  return 0;
+}
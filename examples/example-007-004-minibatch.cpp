@@ -0,0 +1,101 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us evaluate the random policy of the mountain car with a
+// linear TD(0). Rather than updating the weights after each
+// transition, transitions are gathered into minibatches, whose
+// fields are contiguous arrays. Each update is then made of loops
+// over arrays, that the compiler can vectorize.
+
+#define NB_TRANSITIONS 1000000
+#define BATCH_SIZE     256
+#define GRID           10 // The features are GRID x GRID gaussian bumps.
+#define NB_FEATURES    (GRID * GRID)
+#define GAMMA          .99
+#define ALPHA          .1
+
+using car = gdyn::problem::mountain_car::system;
+
+// The columns of phi are the feature vectors of the batch samples
+// (phi[f * BATCH_SIZE + i] is the feature f of sample i).
+template<typename OBSERVATIONS>
+void features(const OBSERVATIONS& observations, std::vector<double>& phi) {
+  gdyn::problem::mountain_car::parameters p;
+  std::size_t size = observations.size();
+  for(unsigned int gp = 0; gp < GRID; ++gp) {
+    double cp = p.min_position + (p.max_position - p.min_position) * gp / (GRID - 1);
+    double sp = (p.max_position - p.min_position) / (GRID - 1);
+    for(unsigned int gv = 0; gv < GRID; ++gv) {
+      double cv = -p.max_speed + 2 * p.max_speed * gv / (GRID - 1);
+      double sv = 2 * p.max_speed / (GRID - 1);
+      double* col = phi.data() + (gp * GRID + gv) * BATCH_SIZE;
+      for(std::size_t i = 0; i < size; ++i) {
+	double dp = (observations[i].position - cp) / sp;
+	double dv = (observations[i].velocity - cv) / sv;
+	col[i] = std::exp(-.5 * (dp * dp + dv * dv));
+      }
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::mountain_car::make();
+  std::vector<double> w(NB_FEATURES, 0.);
+
+  // These buffers are allocated once as well.
+  std::vector<double> phi(NB_FEATURES * BATCH_SIZE), next_phi(NB_FEATURES * BATCH_SIZE);
+  std::vector<double> delta(BATCH_SIZE);
+
+  std::size_t nb_batches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(auto batch
+	: gdyn::views::random_commands<car>(rd())
+	| gdyn::views::episodes(simulator, [&gen, &simulator](){return gdyn::problem::mountain_car::random_state(gen, simulator.param);})
+	| gdyn::views::transition
+	| std::views::take(NB_TRANSITIONS)
+	| gdyn::views::minibatch(BATCH_SIZE)) {
+    std::size_t size = batch.size();
+    features(batch.observations,      phi);
+    features(batch.next_observations, next_phi);
+
+    // delta = r + gamma * (1 - terminal) * w.phi' - w.phi
+    for(std::size_t i = 0; i < size; ++i) delta[i] = batch.reports[i];
+    for(std::size_t f = 0; f < NB_FEATURES; ++f) {
+      const double* col      = phi.data()      + f * BATCH_SIZE;
+      const double* next_col = next_phi.data() + f * BATCH_SIZE;
+      for(std::size_t i = 0; i < size; ++i)
+	delta[i] += w[f] * (GAMMA * (1 - batch.terminals[i]) * next_col[i] - col[i]);
+    }
+
+    // w += alpha * mean(delta * phi)
+    for(std::size_t f = 0; f < NB_FEATURES; ++f) {
+      const double* col = phi.data() + f * BATCH_SIZE;
+      double grad = 0;
+      for(std::size_t i = 0; i < size; ++i) grad += delta[i] * col[i];
+      w[f] += ALPHA * grad / size;
+    }
+    ++nb_batches;
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << nb_batches << " minibatches of " << BATCH_SIZE << " transitions learnt in " << elapsed.count() << "s." << std::endl;
+
+  // Let us display the estimated value at rest for a few positions.
+  std::array<car::observation_type, 5> probes {{{-1.2, 0}, {-.8, 0}, {-.5, 0}, {-.2, 0}, {.4, 0}}};
+  features(probes, phi);
+  for(std::size_t i = 0; i < probes.size(); ++i) {
+    double v = 0;
+    for(std::size_t f = 0; f < NB_FEATURES; ++f) v += w[f] * phi[f * BATCH_SIZE + i];
+    std::cout << "  V(position = " << probes[i].position << ", velocity = 0) = " << v << std::endl;
+  }
+  
+  return 0;
+}
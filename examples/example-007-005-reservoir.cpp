@@ -0,0 +1,56 @@
+#include <iostream>
+#include <random>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us sample transitions from a long stream of grid world
+// transitions, keeping a fixed amount of memory. Most of the
+// transitions have a null report: a uniform sample reflects this,
+// whereas a sample weighted by the report magnitude only keeps
+// transitions with a non null report.
+
+#define NB_TRANSITIONS 10000000
+#define NB_SAMPLES     1000
+
+using grid = gdyn::problem::grid_world::system<10, 10, 55>;
+
+template<typename SAMPLES>
+void describe(const SAMPLES& samples) {
+  unsigned int nb_goal = 0, nb_bump = 0, nb_null = 0;
+  for(const auto& t : samples) {
+    if(t.report > 0)      ++nb_goal;
+    else if(t.report < 0) ++nb_bump;
+    else                  ++nb_null;
+  }
+  std::cout << "  " << nb_goal << " goal, " << nb_bump << " bump and " << nb_null << " null reports." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto simulator = gdyn::problem::grid_world::make<10, 10, 55>();
+  auto transitions = [&simulator, &gen, seed = rd()]() {
+    return gdyn::views::random_commands<grid>(seed)
+      | gdyn::views::episodes(simulator, [&gen](){return grid::random_state(gen);})
+      | gdyn::views::transition
+      | std::views::take(NB_TRANSITIONS);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  auto uniform = transitions() | gdyn::views::reservoir(NB_SAMPLES, rd());
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Uniform sample of " << uniform.size() << " transitions out of " << uniform.seen()
+	    << " (" << elapsed.count() << "s):" << std::endl;
+  describe(uniform.samples());
+
+  start = std::chrono::steady_clock::now();
+  auto weighted = transitions() | gdyn::views::weighted_reservoir(NB_SAMPLES, rd());
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Sample of " << weighted.size() << " transitions out of " << weighted.seen()
+	    << ", weighted by the report magnitude (" << elapsed.count() << "s):" << std::endl;
+  describe(weighted.samples());
+  
+  return 0;
+}
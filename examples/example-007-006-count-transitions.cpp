@@ -0,0 +1,60 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <string>
+
+#include <gdyn.hpp>
+#include "cheesemaze-system.hpp"
+#include "bonobo-system.hpp"
+
+// For finite systems, a long stream of transitions is mostly made of
+// duplicates. Let us count them rather than storing them. Several
+// collectors count their own transitions in parallel, and their
+// tables are merged afterwards.
+
+#define NB_COLLECTORS              8
+#define NB_TRANSITIONS_PER_THREAD  1000000
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+
+  // The cheese maze observations and commands are enumerable, so the
+  // tables are dense arrays.
+  using maze = decltype(cheese_maze::make_environment(cheese_maze::Parameters(), std::declval<std::mt19937&>()));
+  using maze_table = gdyn::count::table<maze::observation_type, maze::command_type, maze::report_type>;
+  std::vector<maze_table> tables(NB_COLLECTORS);
+  std::vector<std::uint64_t> seeds;
+  for(unsigned int c = 0; c < NB_COLLECTORS; ++c) seeds.push_back(rd());
+  gdyn::parallel::for_each_index(NB_COLLECTORS,
+				 [&tables, &seeds](std::size_t c) {
+				   std::mt19937 gen(seeds[c]);
+				   auto simulator = cheese_maze::make_environment(cheese_maze::Parameters(), gen);
+				   tables[c] = gdyn::views::random_commands<maze>(seeds[c], c)
+				     | gdyn::views::episodes(simulator, [&gen](){return cheese_maze::random_state(gen);})
+				     | gdyn::views::transition
+				     | std::views::take(NB_TRANSITIONS_PER_THREAD)
+				     | gdyn::views::count_transitions;
+				 });
+  maze_table maze_counts;
+  for(const auto& table : tables) maze_counts += table;
+  std::cout << "Cheese maze: " << maze_counts.transitions() << " transitions, "
+	    << maze_counts.size() << " distinct (observation, command, next observation)." << std::endl;
+  maze_counts.for_each([](auto observation, auto command, auto next_observation, const auto& e) {
+    if(e.terminals > 0)
+      std::cout << "  " << observation << ' ' << command << " -> " << next_observation
+		<< " : " << e.count << " times, " << e.terminals << " terminal, mean report " << e.mean_report() << std::endl;
+  });
+
+  // Bonobo observations are strings, so the table is a hash table.
+  std::mt19937 gen(rd());
+  Bonobo simulator;
+  auto bonobo_counts = gdyn::views::random_commands<Bonobo>(rd())
+    | gdyn::views::episodes(simulator, [&gen](){return Bonobo::random_state(gen);})
+    | gdyn::views::transition
+    | std::views::take(NB_TRANSITIONS_PER_THREAD)
+    | gdyn::views::count_transitions;
+  std::cout << "Bonobo: " << bonobo_counts.transitions() << " transitions, "
+	    << bonobo_counts.size() << " distinct (observation, command, next observation)." << std::endl;
+  
+  return 0;
+}
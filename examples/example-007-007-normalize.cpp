@@ -0,0 +1,70 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <gdyn.hpp>
+
+// Let us normalize cartpole observations on the fly. First, several
+// collectors gather the statistics of the observations in their own
+// normalizer, and the normalizers are merged. Then, the merged
+// normalizer is frozen and shared by collectors producing normalized
+// transitions.
+
+#define NB_COLLECTORS              4
+#define NB_POINTS_PER_COLLECTOR    1000000
+
+using pole = gdyn::problem::cartpole::system;
+
+void print(const std::string& title, const gdyn::normalizer<pole::observation_type>& normalizer) {
+  auto mean     = normalizer.mean();
+  auto variance = normalizer.variance();
+  std::cout << title << " (" << normalizer.count() << " observations):" << std::endl;
+  std::size_t i = 0;
+  const pole::observation_type any {};
+  gdyn::for_each_field(any, [&mean, &variance, &i](std::string_view name, const auto&) {
+    std::cout << "  " << name << " : mean = " << mean[i] << ", stddev = " << std::sqrt(variance[i]) << std::endl;
+    ++i;
+  });
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::vector<std::uint64_t> seeds;
+  for(unsigned int c = 0; c < NB_COLLECTORS; ++c) seeds.push_back(rd());
+
+  // Each collector feeds its own normalizer.
+  std::vector<gdyn::normalizer<pole::observation_type>> normalizers(NB_COLLECTORS);
+  gdyn::parallel::for_each_index(NB_COLLECTORS,
+				 [&normalizers, &seeds](std::size_t c) {
+				   std::mt19937 gen(seeds[c]);
+				   auto simulator = gdyn::problem::cartpole::make();
+				   for([[maybe_unused]] const auto& point : gdyn::views::random_commands<pole>(seeds[c], c)
+					 | gdyn::views::episodes(simulator, [&gen, &simulator](){return gdyn::problem::cartpole::random_state(gen, simulator.param);})
+					 | std::views::take(NB_POINTS_PER_COLLECTOR)
+					 | gdyn::views::normalize(normalizers[c]));
+				 });
+  gdyn::normalizer<pole::observation_type> merged;
+  for(const auto& normalizer : normalizers) merged += normalizer;
+  print("Raw observations", merged);
+
+  // The merged normalizer is frozen, so that it can be shared. Each
+  // collector checks the statistics of the normalized observations.
+  merged.freeze();
+  std::vector<gdyn::normalizer<pole::observation_type>> checks(NB_COLLECTORS);
+  gdyn::parallel::for_each_index(NB_COLLECTORS,
+				 [&merged, &checks, &seeds](std::size_t c) {
+				   std::mt19937 gen(seeds[c] + 1);
+				   auto simulator = gdyn::problem::cartpole::make();
+				   for(const auto& t : gdyn::views::random_commands<pole>(seeds[c] + 1, c)
+					 | gdyn::views::episodes(simulator, [&gen, &simulator](){return gdyn::problem::cartpole::random_state(gen, simulator.param);})
+					 | std::views::take(NB_POINTS_PER_COLLECTOR)
+					 | gdyn::views::transition
+					 | gdyn::views::normalize(merged))
+				     checks[c].push(t.observation);
+				 });
+  gdyn::normalizer<pole::observation_type> check;
+  for(const auto& normalizer : checks) check += normalizer;
+  print("Normalized observations", check);
+
+  return 0;
+}
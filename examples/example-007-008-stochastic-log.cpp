@@ -0,0 +1,80 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <atomic>
+
+#include "cheesemaze-system.hpp"
+
+// The cheese maze is stochastic: a command may move the agent in
+// another direction. Its episodes can be stored as command logs as
+// well, provided that the maze draws its random values from a
+// gdyn::random::stream whose seed is logged. When the episodes are
+// replayed in parallel, each replay gets a maze with its own stream,
+// so that it draws the same values as when it was recorded.
+
+#define NB_EPISODES 1000
+#define MAX_LENGTH  100
+
+using maze = cheese_maze::Environment<gdyn::random::stream>;
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  cheese_maze::Parameters params;
+
+  // We record episodes, keeping their orbit for further checking.
+  std::vector<gdyn::log::episode<maze>> logs;
+  std::vector<std::vector<std::pair<cheese_maze::Walls, double>>> orbits(NB_EPISODES);
+  std::uint64_t first_seed = rd();
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    std::uint64_t seed = first_seed + e;
+    gdyn::random::stream stream(seed);
+    auto simulator = cheese_maze::make_environment(params, stream);
+    // An episode starting in the terminal cell has no command, and
+    // replaying an empty log gives an empty orbit, so we avoid it.
+    auto initial_state = cheese_maze::random_state(gen);
+    while(initial_state == cheese_maze::Cell::C10) initial_state = cheese_maze::random_state(gen);
+    logs.emplace_back(initial_state, seed);
+    simulator = logs.back().initial_state;
+    for(const auto& point : gdyn::views::random_commands<maze>(rd(), e)
+	  | std::views::take(MAX_LENGTH)
+	  | gdyn::views::orbit(simulator)) {
+      orbits[e].emplace_back(point.current_observation, point.previous_report ? *(point.previous_report) : 0.);
+      if(point.next_command) logs.back().push_back(*(point.next_command));
+    }
+  }
+
+  // Replays are made on mazes built from the stream provided by the
+  // replay.
+  std::atomic<std::size_t> nb_same {0};
+  gdyn::log::replay([&params](gdyn::random::stream& stream) {return cheese_maze::make_environment(params, stream);}, logs,
+		    [&orbits, &nb_same](std::size_t i, auto&& orbit) {
+		      std::size_t t = 0;
+		      bool same = true;
+		      for(const auto& point : orbit) {
+			same = same && t < orbits[i].size()
+			  && point.current_observation == orbits[i][t].first
+			  && (point.previous_report ? *(point.previous_report) : 0.) == orbits[i][t].second;
+			++t;
+		      }
+		      if(same && t == orbits[i].size()) ++nb_same;
+		    });
+  std::cout << nb_same << " replayed episodes out of " << NB_EPISODES << " are the recorded ones." << std::endl;
+
+  // With a wrong seed, the mishaps occur elsewhere.
+  for(auto& log : logs) ++(log.seed);
+  nb_same = 0;
+  gdyn::log::replay([&params](gdyn::random::stream& stream) {return cheese_maze::make_environment(params, stream);}, logs,
+		    [&orbits, &nb_same](std::size_t i, auto&& orbit) {
+		      std::size_t t = 0;
+		      bool same = true;
+		      for(const auto& point : orbit) {
+			same = same && t < orbits[i].size() && point.current_observation == orbits[i][t].first;
+			++t;
+		      }
+		      if(same && t == orbits[i].size()) ++nb_same;
+		    });
+  std::cout << nb_same << " of them are unchanged when they are replayed with another seed." << std::endl;
+
+  return 0;
+}
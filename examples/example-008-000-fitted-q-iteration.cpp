@@ -0,0 +1,77 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us learn a mountain car controller offline, from a dataset of
+// random transitions, by fitted Q-iteration. Two regressors are
+// compared: a linear one on tile-coded features, and extremely
+// randomized trees.
+
+#define NB_EPISODES     2000
+#define EPISODE_LENGTH  10
+#define GAMMA           .99
+#define NB_ITERATIONS   100
+#define NB_TESTS        100
+#define MAX_TEST_LENGTH 1000
+
+using car = gdyn::problem::mountain_car::system;
+using dataset_type = gdyn::store::episodes<car::observation_type, car::command_type, car::report_type>;
+
+// This returns the average length of the episodes driven by the
+// controller, from the usual starting states.
+template<typename CONTROLLER>
+double test(const CONTROLLER& controller, std::mt19937& gen) {
+  auto simulator = gdyn::problem::mountain_car::make();
+  double length = 0;
+  for(unsigned int t = 0; t < NB_TESTS; ++t) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, simulator.param);
+    length += std::ranges::distance(gdyn::views::controller(simulator, controller)
+				    | gdyn::views::orbit(simulator)
+				    | std::views::take(MAX_TEST_LENGTH));
+  }
+  return length / NB_TESTS;
+}
+
+template<typename REGRESSOR>
+void learn(const std::string& name, const REGRESSOR& regressor, const dataset_type& dataset, std::mt19937& gen) {
+  gdyn::fqi::q_function<car::observation_type, car::command_type, REGRESSOR> q(regressor);
+  auto start = std::chrono::steady_clock::now();
+  gdyn::fqi::iterate(q, dataset, GAMMA, NB_ITERATIONS);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  static_assert(gdyn::concepts::controller<gdyn::fqi::greedy<decltype(q)>, car::observation_type, car::command_type>);
+  std::cout << name << ": " << NB_ITERATIONS << " iterations in " << elapsed.count() << "s, "
+	    << "the greedy controller reaches the goal in " << test(gdyn::fqi::greedy(q), gen) << " steps on average." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  // The dataset is made of short episodes of random commands, from
+  // states uniformly drawn in the whole state space. The orbit
+  // points are taken (rather than the commands), so that the last
+  // point of a truncated episode keeps its next command, and the
+  // episode is not mistaken for a terminated one.
+  auto simulator = gdyn::problem::mountain_car::make();
+  const auto& p = simulator.param;
+  dataset_type dataset;
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    simulator = car::state_type {std::uniform_real_distribution<double>(p.min_position, p.max_position)(gen),
+				 std::uniform_real_distribution<double>(-p.max_speed, p.max_speed)(gen)};
+    dataset.push_orbit(gdyn::views::random_commands<car>(rd(), e)
+		       | gdyn::views::orbit(simulator)
+		       | std::views::take(EPISODE_LENGTH + 1));
+  }
+  std::cout << "The dataset has " << dataset.size() << " transitions." << std::endl
+	    << "A random controller reaches the goal in " << test([&gen](const auto&) {return gdyn::problem::mountain_car::random_command(gen);}, gen)
+	    << " steps on average (" << MAX_TEST_LENGTH << " means never)." << std::endl;
+
+  gdyn::tiles::grid<car::observation_type> tiles({p.min_position, -p.max_speed}, {p.max_position, p.max_speed}, 10, 8);
+  learn("Linear on tiles", gdyn::fqi::linear(tiles), dataset, gen);
+  learn("Extra trees    ", gdyn::fqi::extra_trees<car::observation_type>(10, 5, rd()), dataset, gen);
+  
+  return 0;
+}
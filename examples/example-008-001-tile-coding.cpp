@@ -0,0 +1,89 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us first compare the speed of the tile coders on cartpole
+// states. Then, a linear Q function on hashed tiles is learnt online
+// by Q-learning on the mountain car, and used as a controller.
+
+#define NB_CODINGS      1000000
+#define NB_EPISODES     500
+#define MAX_LENGTH      2000
+#define NB_TESTS        100
+#define GAMMA           1
+#define ALPHA           .5
+#define EPSILON         0
+
+using car  = gdyn::problem::mountain_car::system;
+using pole = gdyn::problem::cartpole::system;
+
+template<typename CODER>
+double codings_per_second(const CODER& coder, const std::vector<pole::observation_type>& observations) {
+  std::vector<std::size_t> active(coder.nb_tilings());
+  std::size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(unsigned int i = 0; i < NB_CODINGS; ++i) {
+    coder(observations[i % observations.size()], active);
+    checksum += active[0];
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if(checksum == 0) std::cout << ' ';  // This prevents the loop from being optimized out.
+  return NB_CODINGS / elapsed.count();
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  auto cartpole = gdyn::problem::cartpole::make();
+  std::vector<pole::observation_type> observations;
+  for(unsigned int i = 0; i < 1000; ++i) observations.push_back(gdyn::problem::cartpole::random_state(gen, cartpole.param));
+  std::array<double, 4> min {-2.4, -3, -.21, -3.5}, max {2.4, 3, .21, 3.5};
+  gdyn::tiles::grid<pole::observation_type>   grid(min, max, 8, 16);
+  gdyn::tiles::hashed<pole::observation_type> hashed(min, max, 8, 16, 1 << 16);
+  std::cout << "Cartpole states, 16 tilings:" << std::endl
+	    << "  grid   : " << codings_per_second(grid,   observations) << " codings per second, " << grid.size()   << " features." << std::endl
+	    << "  hashed : " << codings_per_second(hashed, observations) << " codings per second, " << hashed.size() << " features." << std::endl;
+
+  // Let us now learn to drive the mountain car.
+  auto simulator = gdyn::problem::mountain_car::make();
+  const auto& p = simulator.param;
+  gdyn::tiles::linear_q<gdyn::tiles::hashed<car::observation_type>, car::command_type>
+    q(gdyn::tiles::hashed<car::observation_type>({p.min_position, -p.max_speed}, {p.max_position, p.max_speed}, 8, 8, 4096));
+  static_assert(gdyn::concepts::controller<decltype(q), car::observation_type, car::command_type>);
+
+  auto epsilon_greedy = [&gen, &q](const car::observation_type& observation) {
+    if(std::bernoulli_distribution(EPSILON)(gen)) return gdyn::problem::mountain_car::random_command(gen);
+    return q(observation);
+  };
+
+  std::size_t nb_steps = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(unsigned int e = 0; e < NB_EPISODES; ++e) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, p);
+    for(const auto& t : gdyn::views::controller(simulator, epsilon_greedy)
+	  | gdyn::views::orbit(simulator)
+	  | std::views::take(MAX_LENGTH)
+	  | gdyn::views::transition) {
+      double target = t.report + (t.is_terminal() ? 0. : GAMMA * q.best(t.next_observation).second);
+      q.learn(t.observation, t.command, target, ALPHA);
+      ++nb_steps;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Mountain car: " << nb_steps << " Q-learning steps in " << elapsed.count() << "s." << std::endl;
+
+  double length = 0;
+  for(unsigned int t = 0; t < NB_TESTS; ++t) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, p);
+    length += std::ranges::distance(gdyn::views::controller(simulator, q)
+				    | gdyn::views::orbit(simulator)
+				    | std::views::take(MAX_LENGTH));
+  }
+  std::cout << "The greedy controller reaches the goal in " << length / NB_TESTS << " steps on average." << std::endl;
+  
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+#include <gdyn.hpp>
+
+// Let us index a mountain car dataset with a k-d tree, so that
+// non-parametric agents do not scan the whole dataset for each
+// decision. A k-NN controller imitates demonstrations, and a k-NN
+// predictor is used as a model of the system.
+
+#define NB_DEMONSTRATIONS  500
+#define MAX_LENGTH         1000
+#define NB_TESTS           100
+#define K                  5
+#define EPSILON            .5
+#define NB_QUERIES         10000
+#define NB_EPISODES        5000
+#define EPISODE_LENGTH     20
+
+using car = gdyn::problem::mountain_car::system;
+
+// This is the demonstrator: it pushes the car in the direction of its
+// velocity.
+car::command_type pump(const car::observation_type& observation) {
+  if(observation.velocity < 0) return gdyn::problem::mountain_car::acceleration::Left;
+  return gdyn::problem::mountain_car::acceleration::Right;
+}
+
+template<typename CONTROLLER>
+double test(const CONTROLLER& controller, std::mt19937& gen) {
+  auto simulator = gdyn::problem::mountain_car::make();
+  double length = 0;
+  for(unsigned int t = 0; t < NB_TESTS; ++t) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, simulator.param);
+    length += std::ranges::distance(gdyn::views::controller(simulator, controller)
+				    | gdyn::views::orbit(simulator)
+				    | std::views::take(MAX_LENGTH));
+  }
+  return length / NB_TESTS;
+}
+
+template<typename F>
+double seconds_per_call(const F& f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / NB_QUERIES;
+}
+
+int main(int argc, char* argv[]) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  auto simulator = gdyn::problem::mountain_car::make();
+  const auto& p = simulator.param;
+
+  // The fields are scaled so that both span a unit range.
+  std::array<double, 2> scale {1 / (p.max_position - p.min_position), 1 / (2 * p.max_speed)};
+
+  // The demonstrations are (observation, command) pairs.
+  std::vector<car::observation_type> observations;
+  std::vector<car::command_type> commands;
+  for(unsigned int d = 0; d < NB_DEMONSTRATIONS; ++d) {
+    simulator = gdyn::problem::mountain_car::random_state(gen, p);
+    for(const auto& t : gdyn::views::controller(simulator, pump)
+	  | gdyn::views::orbit(simulator)
+	  | std::views::take(MAX_LENGTH)
+	  | gdyn::views::transition) {
+      observations.push_back(t.observation);
+      commands.push_back(t.command);
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  gdyn::knn::tree<car::observation_type> index(observations, scale);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "The tree indexes " << index.size() << " demonstrated observations, it is built in " << elapsed.count() << "s." << std::endl;
+
+  gdyn::knn::controller<car::observation_type, car::command_type> exact(index, commands, K), approximate(index, commands, K, EPSILON);
+  std::cout << "The demonstrator reaches the goal in " << test(pump, gen) << " steps on average." << std::endl
+	    << "The exact k-NN controller reaches it in " << test(exact, gen) << " steps on average." << std::endl
+	    << "The approximate k-NN controller reaches it in " << test(approximate, gen) << " steps on average." << std::endl;
+
+  // Let us compare the query times with a linear scan.
+  std::vector<car::observation_type> queries;
+  for(unsigned int q = 0; q < NB_QUERIES; ++q) queries.push_back(gdyn::problem::mountain_car::random_state(gen, p));
+  std::vector<gdyn::knn::neighbour> neighbours;
+  double checksum = 0;
+  auto tree_time = seconds_per_call([&]() {for(const auto& q : queries) {index.nearest(q, K, neighbours); checksum += neighbours.back().distance;}});
+  auto approximate_time = seconds_per_call([&]() {for(const auto& q : queries) {index.nearest(q, K, neighbours, EPSILON); checksum += neighbours.back().distance;}});
+  auto scan_time = seconds_per_call([&]() {
+    std::vector<double> distances(observations.size());
+    for(const auto& q : queries) {
+      for(std::size_t i = 0; i < observations.size(); ++i) {
+	double dp = (observations[i].position - q.position) * scale[0], dv = (observations[i].velocity - q.velocity) * scale[1];
+	distances[i] = dp * dp + dv * dv;
+      }
+      std::nth_element(distances.begin(), distances.begin() + K - 1, distances.end());
+      checksum += distances[K - 1];
+    }
+  });
+  std::cout << K << " nearest neighbours: " << tree_time * 1e6 << "us with the tree, "
+	    << approximate_time * 1e6 << "us approximately, " << scan_time * 1e6 << "us with a linear scan ("
+	    << checksum << ")." << std::endl;
+
+  // Let us now learn a model of the system from random transitions.
+  gdyn::store::episodes<car::observation_type, car::command_type, car::report_type> dataset;
+  for(std::uint64_t e = 0; e < NB_EPISODES; ++e) {
+    simulator = car::state_type {std::uniform_real_distribution<double>(p.min_position, p.max_position)(gen),
+				 std::uniform_real_distribution<double>(-p.max_speed, p.max_speed)(gen)};
+    dataset.push_orbit(gdyn::views::random_commands<car>(rd(), e)
+		       | gdyn::views::orbit(simulator)
+		       | std::views::take(EPISODE_LENGTH + 1));
+  }
+  gdyn::knn::predictor<car::observation_type, car::command_type> model(dataset, K, 0, scale);
+  double position_error = 0, velocity_error = 0;
+  for(const auto& q : queries) {
+    auto command = gdyn::problem::mountain_car::random_command(gen);
+    simulator = q;
+    simulator(command);
+    auto prediction = model(q, command);
+    position_error += std::fabs(prediction.next_observation.position - (*simulator).position) / NB_QUERIES;
+    velocity_error += std::fabs(prediction.next_observation.velocity - (*simulator).velocity) / NB_QUERIES;
+  }
+  std::cout << "A model learnt from " << dataset.size() << " transitions predicts the next state with a mean error of "
+	    << position_error << " (position) and " << velocity_error << " (velocity)." << std::endl;
+
+  return 0;
+}
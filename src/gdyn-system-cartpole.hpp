@@ -10,6 +10,9 @@
 
 #include <numbers> // pi_v
 
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+
 namespace gdyn {
   namespace problem {
     /**
@@ -25,15 +28,15 @@ namespace gdyn {
 
     namespace cartpole {
       // **************************************************************** Parameters
+      // This is a structural type, so that it can be used as a
+      // template argument (see static_system).
       struct parameters {
 
 	// Physics
 	double gravity {9.81};
 	double mass_cart {1.0};
 	double mass_pole {0.1};
-	double mass_total {mass_cart + mass_pole};
 	double length_halfpole {0.5};
-	double lm_pole {mass_pole * length_halfpole};
 	double force_mag {10.0};
 
 	// Simulation engine
@@ -43,10 +46,17 @@ namespace gdyn {
 	double theta_threshold_rad {12.0 * 2.0 * std::numbers::pi / 360.0};
 	double x_threshold {2.4};
 
-	// Random State generation
+	// Random State generation. The default angle range is half the
+	// default threshold, it has to be set again if the threshold is
+	// changed.
 	double range_x {0.5};
 	double range_theta_rad {theta_threshold_rad / 2.0};
 
+	// Derived values, computed from the current physics, so that
+	// they cannot be inconsistent with it.
+	constexpr double mass_total() const {return mass_cart + mass_pole;}
+	constexpr double lm_pole()    const {return mass_pole * length_halfpole;}
+
       }; // struct parameters
 
       // ******************************************************************* State
@@ -102,31 +112,33 @@ namespace gdyn {
       }
 
       // ***************************************************************************
-      // ****************************************************************** CartPole
+      // ******************************************************************** Engine
       // ***************************************************************************
-      class system {
 
-      public:
+      // This holds the state of a cartpole and performs its
+      // transitions, the parameters being provided at each call. It
+      // is shared by system (runtime parameters) and static_system
+      // (compile-time parameters).
+      class engine {
 
-	parameters param;
+      public:
 
 	// This is required by the gdyn::specs::system concept.
-	using observation_type = state;
+	using observation_type = cartpole::state;
 	using command_type     = direction;
-	using state_type       = state;
+	using state_type       = cartpole::state;
 	using report_type      = double;
 
-      private:
+      protected:
   
-	state_type  _state  {0.0, 0.0, 0.0, 0.0}; // state is already the type name of states.
+	state_type  _state  {0.0, 0.0, 0.0, 0.0}; // state is the type name of states, and the accessor.
 	double      reward {0};
 	bool        terminated {false};
 	bool        just_terminated {false};
 
 	// Reward of 1 until 1 update after going out of bounds
-	void compute_reward() {
+	void compute_reward(const parameters& p) {
 	  terminated = false;
-	  auto p = param;
 	  if (_state.x < - p.x_threshold or _state.x > p.x_threshold
 	      or _state.theta < - p.theta_threshold_rad or _state.theta > p.theta_threshold_rad) {
 	    terminated = true;
@@ -147,17 +159,35 @@ namespace gdyn {
 	  }
 	}
 
-      public:
-	// Constructor initialize parameters
-	system(const parameters& params)  : param(params) {}
-
-	// This is required by the gdyn::specs::system concept.
-	// This is for initializing the state of the system.
-	system& operator=(const state_type& init_state) {
+	void set_state(const state_type& init_state, const parameters& p) {
 	  _state = init_state;
-	  compute_reward();
-	  return *this;
+	  compute_reward(p);
 	}
+
+	report_type step(command_type command, const parameters& p) {
+	  double force {p.force_mag};
+	  if (command == direction::Left) {
+	    force *= -1.0;
+	  }
+
+	  auto theta = _state.theta;
+	  double costheta = std::cos(theta);
+	  double sintheta = std::sin(theta);
+	  double temp = (force + p.lm_pole() * (_state.theta_dot * _state.theta_dot) * sintheta) / p.mass_total();
+	  double theta_acc = (p.gravity * sintheta - costheta * temp) /
+	    (p.length_halfpole * (4.0 / 3.0 - p.mass_pole * (costheta * costheta)) / p.mass_total());
+	  double x_acc = temp - p.lm_pole() * theta_acc * costheta / p.mass_total();
+
+	  _state.x += p.delta_time * _state.x_dot;
+	  _state.x_dot += p.delta_time * x_acc;
+	  _state.theta += p.delta_time * _state.theta_dot;
+	  _state.theta_dot += p.delta_time * theta_acc;
+
+	  compute_reward(p); // and 'terminated'
+	  return reward;
+	}
+
+      public:
   
 	// This is required by the gdyn::spec::system concept.
 	// This returns the obsrvation corresponding to the system's state.
@@ -165,47 +195,108 @@ namespace gdyn {
 	  return _state;
 	}
 
+	// The observation is the state, so the system is transparent.
+	const state_type& state() const {
+	  return _state;
+	}
+
 	// This is required by the gdyn::specs::system concept.
 	// This it true if the system is not in a terminal state.
 	operator bool() const {
 	  return !terminated;
 	}
+      }; // class gdyn::problem::cartpole::engine
 
+      // ***************************************************************************
+      // ****************************************************************** CartPole
+      // ***************************************************************************
+
+      // The parameters are read at each transition, so they can be
+      // modified at any time (e.g. for hyper-parameter sweeps).
+      class system : public engine {
+
+      public:
+
+	parameters param;
+
+	// Constructor initialize parameters
+	system(const parameters& params)  : param(params) {}
+
+	// This is required by the gdyn::specs::system concept.
+	// This is for initializing the state of the system.
+	system& operator=(const state_type& init_state) {
+	  set_state(init_state, param);
+	  return *this;
+	}
+
+	// This changes the parameters, the state is kept.
+	system& operator=(const parameters& params) {
+	  param = params;
+	  return *this;
+	}
   
 	// This is required by the gdyn::specs::system concept.
 	// This performs a state transition.
 	report_type operator()(command_type command) {
+	  return step(command, param);
+	}
 
-	  auto p = param;
-	  double force {p.force_mag};
-	  if (command == direction::Left) {
-	    force *= -1.0;
-	  }
+      }; // class gdyn::problem::cartpole::system
 
-	  auto theta = _state.theta;
-	  double costheta = std::cos(theta);
-	  double sintheta = std::sin(theta);
-	  double temp = (force + p.lm_pole * (_state.theta_dot * _state.theta_dot) * sintheta) / p.mass_total;
-	  double theta_acc = (p.gravity * sintheta - costheta * temp) /
-	    (p.length_halfpole * (4.0 / 3.0 - p.mass_pole * (costheta * costheta)) / p.mass_total);
-	  double x_acc = temp - p.lm_pole * theta_acc * costheta / p.mass_total;
+      // ***************************************************************************
+      // *********************************************************** Static CartPole
+      // ***************************************************************************
 
-	  _state.x += p.delta_time * _state.x_dot;
-	  _state.x_dot += p.delta_time * x_acc;
-	  _state.theta += p.delta_time * _state.theta_dot;
-	  _state.theta_dot += p.delta_time * theta_acc;
+      // Here, the parameters are a template argument. They are known
+      // at compiling time, so that the compiler can fold all the
+      // derived constants and thresholds into the transition.
+      //
+      // static_system<parameters{.mass_pole = .2}> sys;
+      template<parameters PARAMS = parameters{}>
+      class static_system : public engine {
 
-	  compute_reward(); // and 'terminated'
-	  return reward;
+      public:
+
+	static constexpr parameters param = PARAMS;
+
+	// This is required by the gdyn::specs::system concept.
+	// This is for initializing the state of the system.
+	static_system& operator=(const state_type& init_state) {
+	  set_state(init_state, param);
+	  return *this;
+	}
+  
+	// This is required by the gdyn::specs::system concept.
+	// This performs a state transition.
+	report_type operator()(command_type command) {
+	  return step(command, param);
 	}
 
-      }; // class gdyn::problem::cartpole::system
+      }; // class gdyn::problem::cartpole::static_system
 
       auto make(const parameters& params = parameters{}) {
 	return system(params);
       }
 
+      template<parameters PARAMS>
+      auto make_static() {
+	return static_system<PARAMS>();
+      }
+
     } // namespace cartpole
 
   } // namespace problem
+
+  template<>
+  struct enumerable<problem::cartpole::direction> {
+    static constexpr std::array values {problem::cartpole::direction::Left, problem::cartpole::direction::Right};
+  };
+
+  template<>
+  struct fields<problem::cartpole::state> {
+    static constexpr std::tuple values {field {"x",         &problem::cartpole::state::x},
+					field {"x_dot",     &problem::cartpole::state::x_dot},
+					field {"theta",     &problem::cartpole::state::theta},
+					field {"theta_dot", &problem::cartpole::state::theta_dot}};
+  };
 } // namespace gdyn
@@ -7,10 +7,13 @@
 
 // This class fits the gdyn::concepts::system
 
+#include <array>
 #include <iostream>
 #include <random>
 #include <tuple>
 
+#include <gdynEnumerable.hpp>
+
 namespace gdyn {
 namespace problem {
 namespace grid_world {
@@ -141,4 +144,10 @@ inline std::ostream &operator<<(std::ostream &os, dir action) {
 }
 } // namespace grid_world
 } // namespace problem
+
+template <> struct enumerable<problem::grid_world::dir> {
+  static constexpr std::array values{
+      problem::grid_world::dir::North, problem::grid_world::dir::South,
+      problem::grid_world::dir::West, problem::grid_world::dir::East};
+};
 } // namespace gdyn
@@ -1,9 +1,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
 #include <random>
+#include <span>
 #include <string>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
 
 namespace gdyn {
   namespace problem {
@@ -100,7 +109,7 @@ private:
   // Reward of -1 until goal reached
   void compute_reward() {
     terminated = false;
-    auto p = param;
+    const auto& p = param;
 
     reward = -1.0;
     if (_state.position >= p.goal_position and _state.velocity >= p.goal_velocity)
@@ -138,7 +147,7 @@ private:
     auto vel = _state.velocity;
     auto pos = _state.position;
 
-    auto p = param;
+    const auto& p = param;
     double force = p.force;
 
     if (command == acceleration::Left) {
@@ -168,6 +177,123 @@ private:
   auto make(const parameters& params = parameters{}) {
 	return system(params);
   }
+
+// ********************************************************************* fast cosine
+
+// This is a branchless cosine, suited for vectorization. The
+// argument is folded into [-pi/2, pi/2] and the Taylor polynomial up
+// to x^16 is evaluated. As the series is alternating, the absolute
+// error is below (pi/2)^18/18! < 6e-13 for |x| <= 3pi/2, which
+// covers the 3 * position values (i.e. [-3.6, 1.8]) used by the
+// mountain car.
+inline double fast_cos(double x) {
+  double t = std::abs(x);
+  double r = std::min(t, std::numbers::pi - t); // cos(t) = -cos(pi - t)
+  double r2 = r * r;
+  double res = 1.0 / 20922789888000.0;  //  1/16!
+  res = res * r2 - 1.0 / 87178291200.0; // -1/14!
+  res = res * r2 + 1.0 / 479001600.0;   //  1/12!
+  res = res * r2 - 1.0 / 3628800.0;     // -1/10!
+  res = res * r2 + 1.0 / 40320.0;       //  1/8!
+  res = res * r2 - 1.0 / 720.0;         // -1/6!
+  res = res * r2 + 1.0 / 24.0;          //  1/4!
+  res = res * r2 - 0.5;                 // -1/2!
+  res = res * r2 + 1.0;
+  return t > .5 * std::numbers::pi ? -res : res;
+}
+
+// *************************************************************************** batch
+
+// This simulates many mountain cars at once. The states are stored
+// as a structure of arrays, and the transition is computed without
+// any branch, so that the compiler can vectorize it. Each lane
+// behaves as a mountain_car::system, except that the cosine is
+// computed by fast_cos.
+class batch {
+
+public:
+
+  parameters param;
+
+  using state_type   = state;
+  using command_type = acceleration;
+  using report_type  = double;
+
+private:
+
+  std::vector<double>        position;
+  std::vector<double>        velocity;
+  std::vector<unsigned char> terminated; // std::vector<bool> does not vectorize.
+
+public:
+
+  batch(const parameters& params, std::size_t size)
+    : param(params), position(size, 0.0), velocity(size, 0.0), terminated(size, 0) {}
+
+  std::size_t size() const {return position.size();}
+
+  std::span<const double>        positions()  const {return position;}
+  std::span<const double>        velocities() const {return velocity;}
+  std::span<const unsigned char> terminals()  const {return terminated;}
+
+  // This sets the state of the lane i.
+  void set(std::size_t i, const state_type& init_state) {
+    position[i]   = init_state.position;
+    velocity[i]   = init_state.velocity;
+    terminated[i] = (init_state.position >= param.goal_position) & (init_state.velocity >= param.goal_velocity);
+  }
+
+  state_type operator[](std::size_t i) const {return {position[i], velocity[i]};}
+
+  // This is true if the lane i is not in a terminal state.
+  bool running(std::size_t i) const {return !terminated[i];}
+
+  // This performs a transition of each lane, commands[i] being
+  // applied to lane i. The reward is -1 for every lane, so it is
+  // returned once for all. There must be a command per lane, a
+  // std::invalid_argument is thrown otherwise.
+  report_type operator()(std::span<const command_type> commands) {
+    if(commands.size() != size())
+      throw std::invalid_argument("gdyn::problem::mountain_car::batch : there must be a command per lane");
+    const auto& p = param;
+    double* pos = position.data();
+    double* vel = velocity.data();
+    unsigned char* term = terminated.data();
+    const command_type* cmd = commands.data();
+    std::size_t n = size();
+    for(std::size_t i = 0; i < n; ++i) {
+      // Left, None, Right are 0, 1, 2.
+      double force = (static_cast<int>(cmd[i]) - 1) * p.force;
+      double v = vel[i] + force - fast_cos(3.0 * pos[i]) * p.gravity;
+      v = std::min(std::max(v, -p.max_speed), p.max_speed);
+      double x = pos[i] + v;
+      x = std::min(std::max(x, p.min_position), p.max_position);
+      // stop at min_pos
+      v = ((x <= p.min_position) & (v < 0.0)) ? 0.0 : v;
+      pos[i]  = x;
+      vel[i]  = v;
+      term[i] = (x >= p.goal_position) & (v >= p.goal_velocity);
+    }
+    return -1.0;
+  }
+}; // class gdyn::problem::mountain_car::batch
+
+  inline auto make_batch(std::size_t size, const parameters& params = parameters{}) {
+	return batch(params, size);
+  }
     } // namespace mountain_car
   } // namespace problem
+
+  template<>
+  struct enumerable<problem::mountain_car::acceleration> {
+    static constexpr std::array values {problem::mountain_car::acceleration::Left,
+					problem::mountain_car::acceleration::None,
+					problem::mountain_car::acceleration::Right};
+  };
+
+  template<>
+  struct fields<problem::mountain_car::state> {
+    static constexpr std::tuple values {field {"position", &problem::mountain_car::state::position},
+					field {"velocity", &problem::mountain_car::state::velocity}};
+  };
 } // namespace gdyn
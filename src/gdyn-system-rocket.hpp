@@ -3,6 +3,12 @@
 #include <cmath>
 #include <functional>
 #include <iostream>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include <gdynFields.hpp>
 
 /*
   This system is a rocket used in an indoor environment: there is a
@@ -168,9 +174,123 @@ namespace gdyn {
 
 	  report_type operator()(command_type command) {borrowed_system(command); return -std::abs(*(*this));} 
 	};
+
+	/**
+	 * These are the particles of a particle filter estimating the
+	 * phase of a relative rocket from its error (see
+	 * gdyn::system::particle_filter). The target is supposed to be
+	 * constant. The thrust is noisy, and the observed error is
+	 * supposed to have a Gaussian noise. The particles are stored as
+	 * a structure of arrays, so that the physics loops over them can
+	 * be vectorized.
+	 */
+	class particles {
+	public:
+
+	  using estimate_type = phase;
+
+	private:
+
+	  parameters params;
+	  double speed_spread;   // The initial speeds are uniform in [-speed_spread, speed_spread].
+	  double thrust_noise;   // The standard deviation of the thrust.
+	  double error_noise;    // The standard deviation of the observed error.
+	  std::vector<double> errors;
+	  std::vector<double> speeds;
+	  std::vector<double> accelerations; // This is a buffer for the move.
+
+	public:
+
+	  particles(const parameters& params, std::size_t size, double speed_spread, double thrust_noise, double error_noise)
+	    : params(params), speed_spread(speed_spread), thrust_noise(thrust_noise), error_noise(error_noise),
+	      errors(size), speeds(size), accelerations(size) {}
+
+	  std::size_t size() const {return errors.size();}
+
+	  template<typename RANDOM_GENERATOR>
+	  void reset(double error, std::size_t first, std::size_t last, RANDOM_GENERATOR& gen) {
+	    std::normal_distribution<double> e(error, error_noise);
+	    std::uniform_real_distribution<double> v(-speed_spread, speed_spread);
+	    for(std::size_t i = first; i < last; ++i) {
+	      errors[i] = e(gen);
+	      speeds[i] = v(gen);
+	    }
+	  }
+
+	  template<typename RANDOM_GENERATOR>
+	  void move(const thrust& command, std::size_t first, std::size_t last, RANDOM_GENERATOR& gen) {
+	    std::normal_distribution<double> f(command.value, thrust_noise);
+	    double* acc = accelerations.data();
+	    double* err = errors.data();
+	    double* vel = speeds.data();
+	    for(std::size_t i = first; i < last; ++i) acc[i] = f(gen) / params.mass - params.gravity;
+	    if(params.drag_coef != 0) { // Euler integration, as done by the rocket.
+	      double dt = params.internal_euler_dt;
+	      for(double t = dt; t <= command.duration; t += dt)
+		for(std::size_t i = first; i < last; ++i) {
+		  vel[i] += (acc[i] - params.drag_coef * vel[i]) * dt;
+		  err[i] += vel[i] * dt;
+		}
+	    }
+	    else {
+	      double dt = command.duration;
+	      for(std::size_t i = first; i < last; ++i) {
+		double v0 = vel[i];
+		vel[i] = v0 + acc[i] * dt;
+		err[i] += dt * (v0 + .5 * acc[i] * dt);
+	      }
+	    }
+	  }
+
+	  void log_likelihood(double error, std::size_t first, std::size_t last, double* out) const {
+	    double k = -.5 / (error_noise * error_noise);
+	    const double* err = errors.data();
+	    for(std::size_t i = first; i < last; ++i) {
+	      double d = err[i] - error;
+	      out[i] = k * d * d;
+	    }
+	  }
+
+	  void resample(std::span<const std::size_t> ancestors) {
+	    std::vector<double> e(size()), v(size());
+	    for(std::size_t i = 0; i < ancestors.size(); ++i) {
+	      e[i] = errors[ancestors[i]];
+	      v[i] = speeds[ancestors[i]];
+	    }
+	    errors = std::move(e);
+	    speeds = std::move(v);
+	  }
+
+	  phase estimate(std::span<const double> weights) const {
+	    phase res;
+	    for(std::size_t i = 0; i < size(); ++i) {
+	      res.error += weights[i] * errors[i];
+	      res.speed += weights[i] * speeds[i];
+	    }
+	    return res;
+	  }
+	};
       }
     }
   }
+
+  template<>
+  struct fields<problem::rocket::phase> {
+    static constexpr std::tuple values {field {"height", &problem::rocket::phase::height},
+					field {"speed",  &problem::rocket::phase::speed}};
+  };
+
+  template<>
+  struct fields<problem::rocket::thrust> {
+    static constexpr std::tuple values {field {"value",    &problem::rocket::thrust::value},
+					field {"duration", &problem::rocket::thrust::duration}};
+  };
+
+  template<>
+  struct fields<problem::rocket::relative::phase> {
+    static constexpr std::tuple values {field {"error", &problem::rocket::relative::phase::error},
+					field {"speed", &problem::rocket::relative::phase::speed}};
+  };
 }
 
 inline std::ostream& operator<<(std::ostream& os, const gdyn::problem::rocket::phase& p) {
@@ -20,9 +20,25 @@ limitations under the License.
 
 #include <gdynCheckings.hpp>
 #include <gdynIterators.hpp>
+#include <gdynCodec.hpp>
 #include <gdynConcepts.hpp>
+#include <gdynCount.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+#include <gdynFittedQ.hpp>
+#include <gdynKnn.hpp>
+#include <gdynLog.hpp>
+#include <gdynNormalize.hpp>
+#include <gdynParallel.hpp>
+#include <gdynParticleFilter.hpp>
+#include <gdynRandom.hpp>
 #include <gdynSystem.hpp>
 #include <gdynRanges.hpp>
+#include <gdynReservoir.hpp>
+#include <gdynReturns.hpp>
+#include <gdynStore.hpp>
+#include <gdynText.hpp>
+#include <gdynTiles.hpp>
 #include <gdynTransition.hpp>
 
 #include <gdyn-system-grid-world.hpp>
@@ -37,9 +53,28 @@ limitations under the License.
  * @example example-001-002-controller.cpp
  * @example example-001-003-transitions.cpp
  * @example example-001-004-transparent-systems.cpp
+ * @example example-001-005-episodes.cpp
  * @example example-002-001-training.cpp
  * @example example-003-001-cartpole.cpp
  * @example example-004-000-cheesemaze.cpp
+ * @example example-004-001-cheesemaze-random-streams.cpp
+ * @example example-004-002-cheesemaze-history.cpp
+ * @example example-004-003-cheesemaze-belief.cpp
  * @example example-005-000-rocket.cpp
  * @example example-005-001-rocket-relative.cpp
+ * @example example-005-002-rocket-particle-filter.cpp
+ * @example example-006-000-actor-learner.cpp
+ * @example example-006-001-batch-controller.cpp
+ * @example example-007-000-command-log.cpp
+ * @example example-007-001-checkpointed-orbit.cpp
+ * @example example-007-002-codecs.cpp
+ * @example example-007-003-returns.cpp
+ * @example example-007-004-minibatch.cpp
+ * @example example-007-005-reservoir.cpp
+ * @example example-007-006-count-transitions.cpp
+ * @example example-007-007-normalize.cpp
+ * @example example-007-008-stochastic-log.cpp
+ * @example example-008-000-fitted-q-iteration.cpp
+ * @example example-008-001-tile-coding.cpp
+ * @example example-008-002-nearest-neighbours.cpp
  */
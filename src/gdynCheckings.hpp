@@ -22,11 +22,14 @@ limitations under the License.
 // This file is useless for the users of our dynamical-system
 // library. It is only some static checkings that everything is
 // defined right, according to concepts.
+#include <array>
 #include <iterator>
 #include <ranges>
+#include <span>
 #include <vector>
 
 #include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
 #include <gdynIterators.hpp>
 #include <gdynRanges.hpp>
 #include <gdynSystem.hpp>
@@ -80,6 +83,15 @@ namespace gdyn {
     using controller_type = decltype(controller);
     static_assert(concepts::controller<controller_type, system_type::observation_type, system_type::command_type>);
 
+    struct batch_controller_type {
+      std::vector<system_type::command_type> commands;
+      std::span<const system_type::command_type> operator()(std::span<const system_type::observation_type> observations) {
+	commands.resize(observations.size());
+	return commands;
+      }
+    };
+    static_assert(concepts::batch_controller<batch_controller_type, system_type::observation_type, system_type::command_type>);
+
     
     // Pulse
     // -----
@@ -98,6 +110,24 @@ namespace gdyn {
     static_assert(std::input_iterator<pulse_iterator_type>);
 
     
+    // Random commands
+    // ---------------
+
+    enum class toggle : char {On, Off};
+  }
+
+  template<>
+  struct enumerable<checkings::toggle> {
+    static constexpr std::array values {checkings::toggle::On, checkings::toggle::Off};
+  };
+
+  namespace checkings {
+    static_assert(concepts::enumerable<toggle>);
+    using random_commands_type = views::random_commands_view<toggle>;
+    static_assert(std::ranges::view<random_commands_type>);
+    static_assert(std::input_iterator<std::ranges::iterator_t<random_commands_type>>);
+
+    
     // Orbit
     // -----
 
@@ -106,5 +136,33 @@ namespace gdyn {
     static_assert(std::ranges::input_range<orbit_type>);
     static_assert(concepts::orbit_iterator<orbit_iterator_type>);
 
+    
+    // N-step transition
+    // -----------------
+
+    using n_step_transition_type = decltype(std::declval<orbit_type>() | views::n_step_transition(3, .9));
+    static_assert(std::ranges::view<n_step_transition_type>);
+    static_assert(std::input_iterator<std::ranges::iterator_t<n_step_transition_type>>);
+
+    
+    // Episodes
+    // --------
+
+    inline char state_generator() {return 'a';}
+    using episodes_type = decltype(std::declval<pulse_type>() | views::episodes(std::declval<system_type&>(), state_generator));
+    using episodes_iterator_type = std::ranges::iterator_t<episodes_type>;
+    static_assert(std::ranges::view<episodes_type>);
+    static_assert(concepts::orbit_iterator<episodes_iterator_type>);
+
+    
+    // Batch orbit
+    // -----------
+
+    using batch_orbit_type = ranges::batch_orbit_view<system_type, batch_controller_type>;
+    using batch_orbit_iterator_type = std::ranges::iterator_t<batch_orbit_type>;
+    static_assert(std::ranges::view<batch_orbit_type>);
+    static_assert(std::input_iterator<batch_orbit_iterator_type>);
+    static_assert(concepts::orbit_point<std::iter_value_t<batch_orbit_iterator_type>::value_type>);
+
   }
 }
@@ -0,0 +1,371 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynParallel.hpp>
+
+// These are codecs for archiving the columns of a dataset (see
+// store::episodes). A column is split into blocks that are encoded
+// independently, so that a value can be read by decoding its block
+// only, and so that the blocks can be decoded in parallel.
+//
+// A codec provides:
+//   using value_type = ...;
+//   void encode(std::span<const value_type> values, std::vector<std::byte>& out) const; // appends to out.
+//   void decode(std::span<const std::byte> bytes, std::span<value_type> values) const;  // values.size() is the number of encoded values.
+//
+// Decoding never reads out of bytes, a std::runtime_error is thrown
+// if bytes is not a valid encoding of values.size() values.
+
+namespace gdyn {
+  namespace codec {
+
+    namespace details {
+      inline void put_varint(std::uint64_t value, std::vector<std::byte>& out) {
+	while(value >= 0x80) {
+	  out.push_back(std::byte((value & 0x7f) | 0x80));
+	  value >>= 7;
+	}
+	out.push_back(std::byte(value));
+      }
+
+      inline std::byte get_byte(const std::byte*& in, const std::byte* end) {
+	if(in == end)
+	  throw std::runtime_error("gdyn::codec : the encoded block is too short");
+	return *(in++);
+      }
+
+      inline std::uint64_t get_varint(const std::byte*& in, const std::byte* end) {
+	std::uint64_t value = 0;
+	unsigned int shift = 0;
+	std::uint64_t b;
+	do {
+	  if(shift >= 64)
+	    throw std::runtime_error("gdyn::codec : the encoded varint is too long");
+	  b = std::to_integer<std::uint64_t>(get_byte(in, end));
+	  value |= (b & 0x7f) << shift;
+	  shift += 7;
+	} while(b & 0x80);
+	return value;
+      }
+
+      inline std::uint64_t zigzag(std::int64_t value)    {return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);}
+      inline std::int64_t  unzigzag(std::uint64_t value) {return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);}
+    }
+
+    /**
+     * This is a lossless codec for doubles. Each value is xored with
+     * the previous one. Successive values of a smooth signal share
+     * their sign, exponent and high mantissa bits, so the xor has
+     * leading zero bytes, which are not stored. A byte tells how
+     * many bytes are stored, for two successive values.
+     */
+    struct xor_double {
+      using value_type = double;
+
+      void encode(std::span<const double> values, std::vector<std::byte>& out) const {
+	std::uint64_t previous = 0;
+	std::size_t header = 0;
+	for(std::size_t i = 0; i < values.size(); ++i) {
+	  std::uint64_t bits = std::bit_cast<std::uint64_t>(values[i]);
+	  std::uint64_t x = bits ^ previous;
+	  previous = bits;
+	  unsigned int nb_bytes = (std::bit_width(x) + 7) / 8; // in [0, 8], it fits in a nibble.
+	  if(i % 2 == 0) {
+	    header = out.size();
+	    out.push_back(std::byte(nb_bytes));
+	  }
+	  else
+	    out[header] |= std::byte(nb_bytes << 4);
+	  for(unsigned int b = 0; b < nb_bytes; ++b, x >>= 8)
+	    out.push_back(std::byte(x & 0xff));
+	}
+      }
+
+      void decode(std::span<const std::byte> bytes, std::span<double> values) const {
+	const std::byte* in  = bytes.data();
+	const std::byte* end = in + bytes.size();
+	std::uint64_t previous = 0;
+	unsigned int header = 0;
+	for(std::size_t i = 0; i < values.size(); ++i) {
+	  if(i % 2 == 0) header = std::to_integer<unsigned int>(details::get_byte(in, end));
+	  unsigned int nb_bytes = (i % 2 == 0) ? (header & 0xf) : (header >> 4);
+	  if(nb_bytes > 8)
+	    throw std::runtime_error("gdyn::codec::xor_double::decode : bad byte count in header");
+	  std::uint64_t x = 0;
+	  for(unsigned int b = 0; b < nb_bytes; ++b)
+	    x |= std::to_integer<std::uint64_t>(details::get_byte(in, end)) << (8 * b);
+	  previous ^= x;
+	  values[i] = std::bit_cast<double>(previous);
+	}
+      }
+    };
+
+    /**
+     * This is a lossy codec for doubles. Values are rounded to a
+     * multiple of 2 * max_error, so that the decoded value differs
+     * from the original one by max_error at most. The differences of
+     * successive rounded values are stored as variable-length
+     * integers, small differences taking a single byte. The
+     * encoded values must be finite, with |value| / (2 * max_error)
+     * below 2^62 so that every difference is representable, a
+     * std::invalid_argument is thrown otherwise.
+     */
+    struct quantized {
+      using value_type = double;
+
+      double max_error;
+
+      quantized(double max_error) : max_error(max_error) {
+	if(!(max_error > 0))
+	  throw std::invalid_argument("gdyn::codec::quantized : max_error must be positive");
+      }
+
+      void encode(std::span<const double> values, std::vector<std::byte>& out) const {
+	double scale = .5 / max_error;
+	std::int64_t previous = 0;
+	for(auto v : values) {
+	  double scaled = v * scale;
+	  if(!std::isfinite(scaled) || std::fabs(scaled) >= 0x1p62)
+	    throw std::invalid_argument("gdyn::codec::quantized::encode : value is not finite or too large for max_error");
+	  std::int64_t q = std::llround(scaled);
+	  details::put_varint(details::zigzag(q - previous), out);
+	  previous = q;
+	}
+      }
+
+      void decode(std::span<const std::byte> bytes, std::span<double> values) const {
+	double step = 2 * max_error;
+	const std::byte* in  = bytes.data();
+	const std::byte* end = in + bytes.size();
+	std::int64_t q = 0;
+	for(auto& v : values) {
+	  // Wrapping addition, a corrupted stream must not overflow.
+	  q = std::int64_t(std::uint64_t(q) + std::uint64_t(details::unzigzag(details::get_varint(in, end))));
+	  v = q * step;
+	}
+      }
+    };
+
+    /**
+     * This is a lossless codec for enumerable values (e.g. commands),
+     * each value being stored as its rank in enumerable<T>::values,
+     * with as few bits as possible.
+     */
+    template<concepts::enumerable T>
+    struct packed {
+      using value_type = T;
+
+      static constexpr unsigned int nb_bits = std::max(1, static_cast<int>(std::bit_width(cardinal<T> - 1)));
+
+      void encode(std::span<const T> values, std::vector<std::byte>& out) const {
+	std::uint32_t acc = 0;
+	unsigned int nb = 0;
+	for(const auto& v : values) {
+	  acc |= std::uint32_t(index_of(v)) << nb;
+	  nb += nb_bits;
+	  for(; nb >= 8; nb -= 8, acc >>= 8) out.push_back(std::byte(acc & 0xff));
+	}
+	if(nb > 0) out.push_back(std::byte(acc & 0xff));
+      }
+
+      void decode(std::span<const std::byte> bytes, std::span<T> values) const {
+	constexpr std::uint32_t mask = (std::uint32_t(1) << nb_bits) - 1;
+	const std::byte* in  = bytes.data();
+	const std::byte* end = in + bytes.size();
+	std::uint32_t acc = 0;
+	unsigned int nb = 0;
+	for(auto& v : values) {
+	  for(; nb < nb_bits; nb += 8) acc |= std::to_integer<std::uint32_t>(details::get_byte(in, end)) << nb;
+	  if(std::size_t rank = acc & mask; rank < cardinal<T>)
+	    v = value_of<T>(rank);
+	  else
+	    throw std::runtime_error("gdyn::codec::packed::decode : rank out of the enumerable values");
+	  acc >>= nb_bits;
+	  nb -= nb_bits;
+	}
+      }
+    };
+
+    /**
+     * This is an encoded column of values, split into blocks of
+     * block_size values.
+     */
+    template<typename CODEC>
+    class column {
+    public:
+
+      using codec_type = CODEC;
+      using value_type = typename CODEC::value_type;
+
+    private:
+
+      CODEC codec;
+      std::size_t block_size;
+      std::size_t nb_values = 0;
+      std::vector<std::byte> bytes;
+      std::vector<std::size_t> block_offsets {0}; // Block b is in bytes [block_offsets[b], block_offsets[b + 1]).
+
+      // This is the last block decoded by operator[].
+      static constexpr std::size_t no_block = std::numeric_limits<std::size_t>::max();
+      mutable std::vector<value_type> cache;
+      mutable std::size_t cached_block = no_block;
+
+    public:
+
+      column()                         = delete;
+      column(const column&)            = default;
+      column& operator=(const column&) = default;
+      column(column&&)                 = default;
+      column& operator=(column&&)      = default;
+
+      column(const CODEC& codec, std::size_t block_size = 4096) : codec(codec), block_size(std::max(block_size, std::size_t(1))) {}
+
+      /**
+       * This encodes the values, the previous content is cleared.
+       */
+      template<std::ranges::random_access_range VALUES>
+      requires std::ranges::sized_range<VALUES> && std::convertible_to<std::ranges::range_value_t<VALUES>, value_type>
+      void encode(const VALUES& values) {
+	bytes.clear();
+	block_offsets = {0};
+	cached_block = no_block;
+	nb_values = std::ranges::size(values);
+	std::vector<value_type> block;
+	block.reserve(block_size);
+	for(std::size_t start = 0; start < nb_values; start += block_size) {
+	  block.clear();
+	  auto first = std::ranges::begin(values) + start;
+	  std::ranges::copy(first, first + std::min(block_size, nb_values - start), std::back_inserter(block));
+	  codec.encode(std::span<const value_type>(block), bytes);
+	  block_offsets.push_back(bytes.size());
+	}
+      }
+
+      std::size_t size()        const {return nb_values;}
+      std::size_t nb_blocks()   const {return block_offsets.size() - 1;}
+      std::size_t memory_size() const {return bytes.size() + block_offsets.size() * sizeof(std::size_t);}
+
+      /**
+       * This decodes block b into out, that must hold the block
+       * values. It throws a std::invalid_argument otherwise.
+       */
+      void decode_block(std::size_t b, std::span<value_type> out) const {
+	if(b >= nb_blocks())
+	  throw std::invalid_argument("gdyn::codec::column::decode_block : no such block");
+	if(out.size() < std::min(block_size, nb_values - b * block_size))
+	  throw std::invalid_argument("gdyn::codec::column::decode_block : out is too small for the block");
+	codec.decode(std::span<const std::byte>(bytes.data() + block_offsets[b], bytes.data() + block_offsets[b + 1]),
+		     out.first(std::min(block_size, nb_values - b * block_size)));
+      }
+
+      /**
+       * This gets the i-th value. Its block is decoded, unless it is
+       * the block of the previous access, so reading successive
+       * values decodes each block once. Since the decoded block is
+       * kept in the column, concurrent accesses must use different
+       * columns (or decode_block).
+       */
+      value_type operator[](std::size_t i) const {
+	if(std::size_t b = i / block_size; b != cached_block) {
+	  cache.resize(block_size);
+	  cached_block = no_block; // The cache is invalid if decoding throws.
+	  decode_block(b, cache);
+	  cached_block = b;
+	}
+	return cache[i % block_size];
+      }
+
+      /**
+       * This decodes all the values, blocks being decoded by nb_threads
+       * threads. out must hold size() values, a std::invalid_argument
+       * is thrown otherwise.
+       */
+      void decode(std::span<value_type> out, unsigned int nb_threads = std::thread::hardware_concurrency()) const {
+	if(out.size() != nb_values)
+	  throw std::invalid_argument("gdyn::codec::column::decode : out must hold a value per column value");
+	parallel::for_each_index(nb_blocks(),
+				 [this, out](std::size_t b) {decode_block(b, out.subspan(b * block_size));},
+				 nb_threads);
+      }
+
+      std::vector<value_type> decode(unsigned int nb_threads = std::thread::hardware_concurrency()) const {
+	std::vector<value_type> res(nb_values);
+	decode(res, nb_threads);
+	return res;
+      }
+
+      /**
+       * This writes the encoded column in binary form.
+       */
+      void write(std::ostream& os) const {
+	std::uint64_t header[3] = {block_size, nb_values, bytes.size()};
+	os.write(reinterpret_cast<const char*>(header), sizeof(header));
+	os.write(reinterpret_cast<const char*>(block_offsets.data()), block_offsets.size() * sizeof(std::size_t));
+	os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+      }
+
+      /**
+       * This reads a column written by write, with the same
+       * codec. It throws a std::runtime_error if the stream ends too
+       * early, or if the block offsets are inconsistent. The block
+       * contents are checked when they are decoded, which throws a
+       * std::runtime_error for a corrupted block.
+       */
+      void read(std::istream& is) {
+	std::uint64_t header[3];
+	is.read(reinterpret_cast<char*>(header), sizeof(header));
+	if(!is)
+	  throw std::runtime_error("gdyn::codec::column::read : truncated header");
+	if(header[0] == 0)
+	  throw std::runtime_error("gdyn::codec::column::read : null block size");
+	block_size = header[0];
+	nb_values  = header[1];
+	block_offsets.resize((nb_values + block_size - 1) / block_size + 1);
+	bytes.resize(header[2]);
+	is.read(reinterpret_cast<char*>(block_offsets.data()), block_offsets.size() * sizeof(std::size_t));
+	is.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+	if(!is)
+	  throw std::runtime_error("gdyn::codec::column::read : truncated content");
+	cached_block = no_block;
+	if(block_offsets.front() != 0 || block_offsets.back() != bytes.size()
+	   || !std::ranges::is_sorted(block_offsets))
+	  throw std::runtime_error("gdyn::codec::column::read : inconsistent block offsets");
+      }
+    };
+  }
+}
@@ -23,6 +23,11 @@ limitations under the License.
 #include <iterator>
 #include <tuple>
 #include <concepts>
+#include <span>
+
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+#include <gdynRandom.hpp>
 
 
 namespace gdyn {
@@ -79,6 +84,101 @@ namespace gdyn {
       {constant_controller(constant_observation)} -> std::convertible_to<COMMAND>;
     };
 
+    /**
+     * @short This specifies a controller that computes the commands
+     * for many observations at once.
+     *
+     * The returned span holds a command for each observation, it is
+     * usually a buffer owned by the controller. This is why the
+     * controller is not required to be constant.
+     */
+    template<typename CONTROLLER, typename OBSERVATION, typename COMMAND>
+    concept batch_controller =
+      requires(CONTROLLER controller,
+	       std::span<const OBSERVATION> observations) {
+      {controller(observations)} -> std::convertible_to<std::span<const COMMAND>>;
+    };
+
+    /**
+     * @short This specifies a regressor, i.e. a function from inputs
+     * to doubles that is fitted to samples.
+     *
+     * fit(inputs, targets, nb_threads) may use nb_threads threads,
+     * and may start from the current fit (warm start). The
+     * prediction must be safe to call concurrently.
+     */
+    template<typename REGRESSOR, typename INPUT>
+    concept regressor =
+      std::copy_constructible<REGRESSOR>
+      && requires(REGRESSOR regressor, REGRESSOR const constant_regressor,
+		  std::span<const INPUT> inputs, std::span<const double> targets,
+		  INPUT const constant_input, unsigned int nb_threads) {
+      regressor.fit(inputs, targets, nb_threads);
+      {constant_regressor(constant_input)} -> std::convertible_to<double>;
+    };
+    
+    /**
+     * @short This specifies a set of particles, i.e. hypotheses about
+     * the hidden state of a system, for gdyn::system::particle_filter.
+     *
+     * The particles are handled by ranges [first, last), so that
+     * disjoint ranges can be processed concurrently, each one with its
+     * own random stream.
+     * - reset draws the particles from the prior, given the first
+     *   observation.
+     * - move performs the transition of the particles (with process
+     *   noise).
+     * - log_likelihood writes in out[i] the log-likelihood of the
+     *   observation for particle i.
+     * reset and log_likelihood may take, right after the observation,
+     * a bool telling whether the system is in a terminal state, when
+     * it is part of what is observed.
+     * - resample makes particle i a copy of particle ancestors[i].
+     * - estimate is the estimation of the state from the particle
+     *   weights.
+     */
+    template<typename PARTICLES, typename OBSERVATION, typename COMMAND>
+    concept particles =
+      requires {
+      typename PARTICLES::estimate_type;
+    } &&
+    requires(PARTICLES set, PARTICLES const constant_set,
+	     OBSERVATION const constant_observation, COMMAND const constant_command,
+	     std::size_t first, std::size_t last, random::stream& gen, double* out, bool terminal,
+	     std::span<const std::size_t> ancestors, std::span<const double> weights) {
+      {constant_set.size()} -> std::convertible_to<std::size_t>;
+      requires
+	requires {set.reset(constant_observation, first, last, gen);} ||
+	requires {set.reset(constant_observation, terminal, first, last, gen);};
+      set.move(constant_command, first, last, gen);
+      requires
+	requires {constant_set.log_likelihood(constant_observation, first, last, out);} ||
+	requires {constant_set.log_likelihood(constant_observation, terminal, first, last, out);};
+      set.resample(ancestors);
+      {constant_set.estimate(weights)} -> std::convertible_to<typename PARTICLES::estimate_type>;
+    };
+    
+    /**
+     * @short This specifies a type whose values can be enumerated
+     * (see gdyn::enumerable).
+     */
+    template<typename T>
+    concept enumerable =
+      requires {
+      {gdyn::enumerable<T>::values.size()} -> std::convertible_to<std::size_t>;
+      {gdyn::enumerable<T>::values[0]} -> std::convertible_to<const T&>;
+    };
+
+    /**
+     * @short This specifies a type whose fields are listed (see
+     * gdyn::fields).
+     */
+    template<typename T>
+    concept reflected =
+      requires {
+      {std::tuple_size<std::remove_const_t<decltype(gdyn::fields<T>::values)>>::value} -> std::convertible_to<std::size_t>;
+    };
+
     /**
      * @short This specifies an iterator providing commands to a system.
      */
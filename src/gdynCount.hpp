@@ -0,0 +1,270 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+
+// For finite systems, most of the transitions of a long stream are
+// duplicates. Rather than storing them, we can count them: a count
+// table gathers, for each (observation, command, next observation),
+// the number of transitions, the number of terminal ones and the
+// sum of their reports.
+//
+// When the observations and the commands are enumerable, the table
+// is a dense array. Otherwise, it is a hash table (the observations
+// and commands must be hashable by std::hash).
+//
+// Tables can be merged with +=, so that several threads can collect
+// transitions in their own table, and the tables are added at the
+// end.
+
+namespace gdyn {
+  namespace count {
+
+    template<typename REPORT>
+    struct entry {
+      std::uint64_t count     = 0;
+      std::uint64_t terminals = 0; //!< the number of transitions leading to a terminal state.
+      REPORT        report_sum {};
+
+      entry& operator+=(const entry& other) {
+	count      += other.count;
+	terminals  += other.terminals;
+	report_sum += other.report_sum;
+	return *this;
+      }
+
+      double mean_report() const {return count == 0 ? 0. : static_cast<double>(report_sum) / count;}
+    };
+
+
+    /**
+     * This is a count table stored as a dense array, indexed by the
+     * ranks of the observations and commands.
+     */
+    template<concepts::enumerable OBSERVATION, concepts::enumerable COMMAND, typename REPORT>
+    class dense {
+    public:
+
+      using observation_type = OBSERVATION;
+      using command_type     = COMMAND;
+      using report_type      = REPORT;
+      using entry_type       = entry<REPORT>;
+
+    private:
+
+      static constexpr std::size_t nb_observations = cardinal<OBSERVATION>;
+      static constexpr std::size_t nb_commands     = cardinal<COMMAND>;
+
+      std::vector<entry_type> entries;
+      std::uint64_t nb_transitions = 0;
+
+      static std::size_t rank(const OBSERVATION& observation, const COMMAND& command, const OBSERVATION& next_observation) {
+	return (index_of(observation) * nb_commands + index_of(command)) * nb_observations + index_of(next_observation);
+      }
+
+    public:
+
+      dense() : entries(nb_observations * nb_commands * nb_observations) {}
+      dense(const dense&)            = default;
+      dense& operator=(const dense&) = default;
+      dense(dense&&)                 = default;
+      dense& operator=(dense&&)      = default;
+
+      template<typename TRANSITION>
+      dense& operator+=(const TRANSITION& t) {
+	auto& e = entries[rank(t.observation, t.command, t.next_observation)];
+	++e.count;
+	e.terminals += t.is_terminal();
+	e.report_sum += t.report;
+	++nb_transitions;
+	return *this;
+      }
+
+      dense& operator+=(const dense& other) {
+	for(std::size_t i = 0; i < entries.size(); ++i) entries[i] += other.entries[i];
+	nb_transitions += other.nb_transitions;
+	return *this;
+      }
+
+      /**
+       * The number of transitions added so far.
+       */
+      std::uint64_t transitions() const {return nb_transitions;}
+
+      /**
+       * The number of distinct triplets.
+       */
+      std::size_t size() const {return std::ranges::count_if(entries, [](const auto& e) {return e.count > 0;});}
+
+      const entry_type& operator()(const OBSERVATION& observation, const COMMAND& command, const OBSERVATION& next_observation) const {
+	return entries[rank(observation, command, next_observation)];
+      }
+
+      /**
+       * This calls f(observation, command, next_observation, entry)
+       * for each triplet that has been counted.
+       */
+      template<typename F>
+      void for_each(const F& f) const {
+	std::size_t i = 0;
+	for(const auto& o : enumerable<OBSERVATION>::values)
+	  for(const auto& c : enumerable<COMMAND>::values)
+	    for(const auto& no : enumerable<OBSERVATION>::values)
+	      if(const auto& e = entries[i++]; e.count > 0) f(o, c, no, e);
+      }
+    };
+
+
+    /**
+     * This is a count table stored as a hash table.
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    class hashed {
+    public:
+
+      using observation_type = OBSERVATION;
+      using command_type     = COMMAND;
+      using report_type      = REPORT;
+      using entry_type       = entry<REPORT>;
+
+    private:
+
+      struct key {
+	OBSERVATION observation;
+	COMMAND     command;
+	OBSERVATION next_observation;
+	bool operator==(const key&) const = default;
+      };
+
+      struct key_hash {
+	std::size_t operator()(const key& k) const {
+	  std::size_t h = std::hash<OBSERVATION>()(k.observation);
+	  h = h * 0x9E3779B97F4A7C15ull + std::hash<COMMAND>()(k.command);
+	  return h * 0x9E3779B97F4A7C15ull + std::hash<OBSERVATION>()(k.next_observation);
+	}
+      };
+
+      std::unordered_map<key, entry_type, key_hash> entries;
+      std::uint64_t nb_transitions = 0;
+      static inline const entry_type none {};
+
+    public:
+
+      hashed()                         = default;
+      hashed(const hashed&)            = default;
+      hashed& operator=(const hashed&) = default;
+      hashed(hashed&&)                 = default;
+      hashed& operator=(hashed&&)      = default;
+
+      template<typename TRANSITION>
+      hashed& operator+=(const TRANSITION& t) {
+	auto& e = entries[key {t.observation, t.command, t.next_observation}];
+	++e.count;
+	e.terminals += t.is_terminal();
+	e.report_sum += t.report;
+	++nb_transitions;
+	return *this;
+      }
+
+      hashed& operator+=(const hashed& other) {
+	for(const auto& [k, e] : other.entries) entries[k] += e;
+	nb_transitions += other.nb_transitions;
+	return *this;
+      }
+
+      /**
+       * The number of transitions added so far.
+       */
+      std::uint64_t transitions() const {return nb_transitions;}
+
+      /**
+       * The number of distinct triplets.
+       */
+      std::size_t size() const {return entries.size();}
+
+      const entry_type& operator()(const OBSERVATION& observation, const COMMAND& command, const OBSERVATION& next_observation) const {
+	if(auto it = entries.find(key {observation, command, next_observation}); it != entries.end()) return it->second;
+	return none;
+      }
+
+      /**
+       * This calls f(observation, command, next_observation, entry)
+       * for each triplet that has been counted.
+       */
+      template<typename F>
+      void for_each(const F& f) const {
+	for(const auto& [k, e] : entries) f(k.observation, k.command, k.next_observation, e);
+      }
+    };
+
+
+    namespace details {
+      template<typename OBSERVATION, typename COMMAND, typename REPORT>
+      struct table {using type = hashed<OBSERVATION, COMMAND, REPORT>;};
+      
+      template<concepts::enumerable OBSERVATION, concepts::enumerable COMMAND, typename REPORT>
+      struct table<OBSERVATION, COMMAND, REPORT> {using type = dense<OBSERVATION, COMMAND, REPORT>;};
+    }
+    
+    /**
+     * This is the dense table when possible, the hashed one otherwise.
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    using table = typename details::table<OBSERVATION, COMMAND, REPORT>::type;
+  }
+
+  namespace ranges {
+    namespace details {
+      struct count_transitions_closure {
+	constexpr count_transitions_closure() {}
+	template <std::ranges::input_range R> auto operator()(R&& from) const {
+	  using transition = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+	  count::table<std::remove_cvref_t<decltype(std::declval<transition>().observation)>,
+		       std::remove_cvref_t<decltype(std::declval<transition>().command)>,
+		       std::remove_cvref_t<decltype(std::declval<transition>().report)>> res;
+	  for(const auto& t : std::forward<R>(from)) res += t;
+	  return res;
+	}
+      };
+
+      template <std::ranges::input_range R>
+      auto operator | (R&& from, count_transitions_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+
+    namespace views {
+      /**
+       * This is a sink: transitions | count_transitions consumes the
+       * transitions (which must end), and returns their count::table.
+       */
+      constexpr auto count_transitions = details::count_transitions_closure();
+    }
+  }
+}
@@ -0,0 +1,63 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace gdyn {
+
+  /**
+   * This is to be specialized for types having a finite number of
+   * values (e.g. the commands of many systems). The specialization
+   * must provide a static constexpr std::array named values, which
+   * lists all the possible values.
+   *
+   * template<> struct gdyn::enumerable<my_command> {
+   *   static constexpr std::array values {my_command::A, my_command::B};
+   * };
+   */
+  template<typename T>
+  struct enumerable {};
+
+  /**
+   * The number of values of an enumerable type.
+   */
+  template<typename T>
+  inline constexpr std::size_t cardinal = enumerable<T>::values.size();
+
+  /**
+   * The rank of value in the enumerable<T>::values array.
+   */
+  template<typename T>
+  constexpr std::size_t index_of(const T& value) {
+    std::size_t idx = 0;
+    for(const auto& v : enumerable<T>::values) {
+      if(v == value) return idx;
+      ++idx;
+    }
+    return idx;
+  }
+
+  /**
+   * The value whose rank is idx in the enumerable<T>::values array.
+   */
+  template<typename T>
+  constexpr T value_of(std::size_t idx) {return enumerable<T>::values[idx];}
+}
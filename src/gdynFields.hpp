@@ -0,0 +1,95 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <tuple>
+
+namespace gdyn {
+
+  /**
+   * This names a data member of a class.
+   */
+  template<typename CLASS, typename T>
+  struct field {
+    using class_type = CLASS;
+    using value_type = T;
+    std::string_view name;
+    T CLASS::* member;
+  };
+
+  template<typename CLASS, typename T>
+  field(std::string_view, T CLASS::*) -> field<CLASS, T>;
+
+  /**
+   * This is to be specialized for the structures (e.g. the states of
+   * the problems) whose data members have to be handled one by one
+   * (e.g. for exporting them as text columns). The specialization
+   * must provide a static constexpr std::tuple named values, which
+   * lists the fields.
+   *
+   * template<> struct gdyn::fields<my_state> {
+   *   static constexpr std::tuple values {gdyn::field {"x", &my_state::x}, gdyn::field {"y", &my_state::y}};
+   * };
+   */
+  template<typename T>
+  struct fields {};
+
+  /**
+   * The number of fields of a type.
+   */
+  template<typename T>
+  inline constexpr std::size_t nb_fields = std::tuple_size_v<std::remove_const_t<decltype(fields<T>::values)>>;
+
+  /**
+   * This calls f(name, value) for each field of object, in the order
+   * of the fields<T>::values tuple.
+   */
+  template<typename T, typename F>
+  constexpr void for_each_field(T& object, F&& f) {
+    std::apply([&object, &f](const auto&... fld) {(f(fld.name, object.*(fld.member)), ...);}, fields<std::remove_const_t<T>>::values);
+  }
+
+  /**
+   * This gathers the fields of object into an array of doubles
+   * (e.g. for feeding a regressor with an observation).
+   */
+  template<typename T>
+  constexpr std::array<double, nb_fields<T>> as_array(const T& object) {
+    std::array<double, nb_fields<T>> res;
+    std::size_t i = 0;
+    for_each_field(object, [&res, &i](std::string_view, const auto& value) {res[i++] = static_cast<double>(value);});
+    return res;
+  }
+
+  /**
+   * This is the converse of as_array, the fields of the returned
+   * object are set from the values.
+   */
+  template<typename T>
+  constexpr T from_array(const std::array<double, nb_fields<T>>& values) {
+    T res {};
+    std::size_t i = 0;
+    for_each_field(res, [&values, &i](std::string_view, auto& value) {value = static_cast<std::remove_cvref_t<decltype(value)>>(values[i++]);});
+    return res;
+  }
+}
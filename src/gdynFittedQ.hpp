@@ -0,0 +1,451 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+#include <gdynParallel.hpp>
+#include <gdynRandom.hpp>
+#include <gdynTiles.hpp>
+
+// This implements fitted Q-iteration (FQI), from
+//   D. Ernst, P. Geurts and L. Wehenkel, "Tree-based batch mode
+//   reinforcement learning", JMLR 6, 2005.
+//
+// The Q function of a system with enumerable commands is made of a
+// regressor per command, whose input is the observation. An
+// iteration computes the targets r + gamma * max_a Q(s', a) of all
+// the transitions of a dataset, and fits each regressor to the
+// targets of the transitions with its command. Both steps run in
+// parallel.
+//
+// A regressor fits the concepts::regressor concept. Two of them are
+// provided here:
+//   - linear, on the features of a tile coder (see gdyn::tiles),
+//   - extra_trees, the extremely randomized trees of Geurts et al.
+
+namespace gdyn {
+  namespace fqi {
+
+    namespace details {
+      // This calls f(begin, end) for nb_blocks contiguous blocks
+      // covering [0, size), from nb_threads threads.
+      template<typename F>
+      void for_each_block(std::size_t size, std::size_t nb_blocks, const F& f, unsigned int nb_threads) {
+	nb_blocks = std::max(nb_blocks, std::size_t(1));
+	std::size_t block_size = (size + nb_blocks - 1) / nb_blocks;
+	parallel::for_each_index(nb_blocks,
+				 [size, block_size, &f](std::size_t b) {
+				   std::size_t begin = std::min(b * block_size, size);
+				   f(b, begin, std::min(begin + block_size, size));
+				 },
+				 nb_threads);
+      }
+
+      inline constexpr std::size_t block_size = 1024;
+    }
+
+    /**
+     * This is a linear regressor on the binary features of a tile
+     * coder (see gdyn::tiles).
+     *
+     * The fit consists of gradient steps, where the gradient of each
+     * weight is normalized by the number of samples activating it, and
+     * the weights of the previous fit are the starting point.
+     */
+    template<typename CODER>
+    class linear {
+    public:
+
+      using input_type = typename CODER::input_type;
+
+    private:
+
+      CODER coder;
+      std::vector<double> w;
+      unsigned int nb_epochs;
+      double step;
+
+    public:
+
+      linear()                         = delete;
+      linear(const linear&)            = default;
+      linear& operator=(const linear&) = default;
+      linear(linear&&)                 = default;
+      linear& operator=(linear&&)      = default;
+
+      linear(const CODER& coder, unsigned int nb_epochs = 10, double step = 1)
+	: coder(coder), w(coder.size(), 0.), nb_epochs(nb_epochs), step(step) {
+	if(coder.nb_tilings() > tiles::max_tilings)
+	  throw std::invalid_argument("gdyn::fqi::linear : too many tilings");
+      }
+
+      std::span<const double> weights() const {return w;}
+
+      double operator()(const input_type& input) const {
+	std::array<std::size_t, tiles::max_tilings> active;
+	std::span<std::size_t> a(active.data(), coder.nb_tilings());
+	coder(input, a);
+	return tiles::dot(w, a);
+      }
+
+      void fit(std::span<const input_type> inputs, std::span<const double> targets, unsigned int nb_threads) {
+	std::size_t n = inputs.size();
+	std::size_t nb_active = coder.nb_tilings();
+	std::size_t nb_features = w.size();
+	std::size_t nb_blocks = std::max(nb_threads, 1u);
+
+	std::vector<std::size_t> active(n * nb_active);
+	details::for_each_block(n, (n + details::block_size - 1) / details::block_size,
+				[this, &inputs, &active, nb_active](std::size_t, std::size_t begin, std::size_t end) {
+				  for(std::size_t i = begin; i < end; ++i)
+				    coder(inputs[i], std::span<std::size_t>(active.data() + i * nb_active, nb_active));
+				},
+				nb_threads);
+	std::vector<double> rates(nb_features, 0.);
+	for(auto idx : active) ++rates[idx];
+	for(auto& r : rates) if(r > 0) r = step / (r * nb_active);
+
+	// Each block accumulates its own gradient, they are summed up afterwards.
+	std::vector<double> gradients(nb_blocks * nb_features);
+	for(unsigned int epoch = 0; epoch < nb_epochs; ++epoch) {
+	  details::for_each_block(n, nb_blocks,
+				  [this, &active, &targets, &gradients, nb_active, nb_features](std::size_t b, std::size_t begin, std::size_t end) {
+				    double* g = gradients.data() + b * nb_features;
+				    std::fill(g, g + nb_features, 0.);
+				    for(std::size_t i = begin; i < end; ++i) {
+				      const std::size_t* a = active.data() + i * nb_active;
+				      double error = targets[i];
+				      for(std::size_t t = 0; t < nb_active; ++t) error -= w[a[t]];
+				      for(std::size_t t = 0; t < nb_active; ++t) g[a[t]] += error;
+				    }
+				  },
+				  nb_threads);
+	  details::for_each_block(nb_features, (nb_features + details::block_size - 1) / details::block_size,
+				  [this, &gradients, &rates, nb_blocks, nb_features](std::size_t, std::size_t begin, std::size_t end) {
+				    for(std::size_t b = 1; b < nb_blocks; ++b) {
+				      const double* g = gradients.data() + b * nb_features;
+				      for(std::size_t j = begin; j < end; ++j) gradients[j] += g[j];
+				    }
+				    for(std::size_t j = begin; j < end; ++j) w[j] += rates[j] * gradients[j];
+				  },
+				  nb_threads);
+	}
+      }
+    };
+
+
+    /**
+     * These are the extremely randomized trees from
+     *   P. Geurts, D. Ernst and L. Wehenkel, "Extremely randomized
+     *   trees", Machine Learning 63(1), 2006.
+     *
+     * The input is a reflected structure (see gdyn::fields). A node
+     * is split by drawing a random threshold for nb_candidates random
+     * fields, and keeping the split that reduces the variance of the
+     * targets the most. Nodes with less than min_split samples are
+     * leaves. The trees are built in parallel, each one from its own
+     * gdyn::random::stream.
+     */
+    template<concepts::reflected INPUT>
+    class extra_trees {
+    public:
+
+      using input_type = INPUT;
+      static constexpr std::size_t dim = nb_fields<INPUT>;
+
+    private:
+
+      struct node {
+	std::uint32_t feature   = 0;
+	double        threshold = 0;
+	std::uint32_t left      = 0; // 0 for a leaf (the root is nobody's child).
+	std::uint32_t right     = 0;
+	double        value     = 0;
+      };
+      using tree = std::vector<node>;
+      using sample = std::array<double, dim>;
+
+      std::vector<tree> trees;
+      unsigned int nb_trees;
+      unsigned int min_split;
+      unsigned int nb_candidates;
+      std::uint64_t seed;
+      std::uint32_t nb_fits = 0;
+
+      void build(tree& t, const std::vector<sample>& xs, std::span<const double> ys, random::stream& gen) const {
+	std::vector<std::uint32_t> idx(xs.size());
+	std::iota(idx.begin(), idx.end(), 0);
+	struct todo {std::uint32_t node; std::size_t begin, end;};
+	std::vector<todo> stack {{0, 0, idx.size()}};
+	t.assign(1, node());
+	std::array<std::size_t, dim> features;
+	while(!stack.empty()) {
+	  auto [k, begin, end] = stack.back();
+	  stack.pop_back();
+	  std::size_t n = end - begin;
+	  double sum = 0;
+	  for(std::size_t i = begin; i < end; ++i) sum += ys[idx[i]];
+	  t[k].value = n > 0 ? sum / n : 0;
+	  if(n < min_split) continue;
+
+	  // Constant fields or targets cannot be split.
+	  std::array<double, dim> lo, hi;
+	  lo.fill(std::numeric_limits<double>::max());
+	  hi.fill(std::numeric_limits<double>::lowest());
+	  double y_lo = ys[idx[begin]], y_hi = y_lo;
+	  for(std::size_t i = begin; i < end; ++i) {
+	    const auto& x = xs[idx[i]];
+	    for(std::size_t f = 0; f < dim; ++f) {
+	      lo[f] = std::min(lo[f], x[f]);
+	      hi[f] = std::max(hi[f], x[f]);
+	    }
+	    y_lo = std::min(y_lo, ys[idx[i]]);
+	    y_hi = std::max(y_hi, ys[idx[i]]);
+	  }
+	  if(y_lo == y_hi) continue;
+	  std::size_t nb_features = 0;
+	  for(std::size_t f = 0; f < dim; ++f) if(lo[f] < hi[f]) features[nb_features++] = f;
+	  if(nb_features == 0) continue;
+
+	  double best_score = std::numeric_limits<double>::lowest();
+	  std::size_t best_feature = 0;
+	  double best_threshold = 0;
+	  std::size_t nb_drawn = std::min<std::size_t>(nb_candidates, nb_features);
+	  for(std::size_t c = 0; c < nb_drawn; ++c) {
+	    std::swap(features[c], features[std::uniform_int_distribution<std::size_t>(c, nb_features - 1)(gen)]);
+	    std::size_t f = features[c];
+	    double threshold = std::uniform_real_distribution<double>(lo[f], hi[f])(gen);
+	    double sum_left = 0;
+	    std::size_t n_left = 0;
+	    for(std::size_t i = begin; i < end; ++i)
+	      if(xs[idx[i]][f] <= threshold) {
+		sum_left += ys[idx[i]];
+		++n_left;
+	      }
+	    if(n_left == n) continue; // This may happen for rounding reasons.
+	    double sum_right = sum - sum_left;
+	    double score = sum_left * sum_left / n_left + sum_right * sum_right / (n - n_left); // The variance reduction, up to constants.
+	    if(score > best_score) {
+	      best_score = score;
+	      best_feature = f;
+	      best_threshold = threshold;
+	    }
+	  }
+	  if(best_score == std::numeric_limits<double>::lowest()) continue;
+
+	  auto middle = std::partition(idx.begin() + begin, idx.begin() + end,
+				       [&xs, best_feature, best_threshold](std::uint32_t i) {return xs[i][best_feature] <= best_threshold;});
+	  std::uint32_t left = static_cast<std::uint32_t>(t.size());
+	  t[k].feature   = static_cast<std::uint32_t>(best_feature);
+	  t[k].threshold = best_threshold;
+	  t[k].left      = left;
+	  t[k].right     = left + 1;
+	  t.resize(t.size() + 2);
+	  std::size_t split = middle - idx.begin();
+	  stack.push_back({left,     begin, split});
+	  stack.push_back({left + 1, split, end});
+	}
+      }
+
+    public:
+
+      extra_trees()                              = delete;
+      extra_trees(const extra_trees&)            = default;
+      extra_trees& operator=(const extra_trees&) = default;
+      extra_trees(extra_trees&&)                 = default;
+      extra_trees& operator=(extra_trees&&)      = default;
+
+      /**
+       * @param nb_candidates The number of fields tried at each split (all of them by default).
+       */
+      extra_trees(unsigned int nb_trees = 50, unsigned int min_split = 2, std::uint64_t seed = 0, unsigned int nb_candidates = dim)
+	: nb_trees(nb_trees), min_split(std::max(min_split, 2u)), nb_candidates(std::max(nb_candidates, 1u)), seed(seed) {
+	if(nb_trees == 0)
+	  throw std::invalid_argument("gdyn::fqi::extra_trees : nb_trees must be positive");
+      }
+
+      /**
+       * The trees of the previous fit are discarded.
+       */
+      void fit(std::span<const INPUT> inputs, std::span<const double> targets, unsigned int nb_threads) {
+	std::vector<sample> xs(inputs.size());
+	for(std::size_t i = 0; i < inputs.size(); ++i) xs[i] = as_array(inputs[i]);
+	trees.assign(nb_trees, tree());
+	parallel::for_each_index(nb_trees,
+				 [this, &xs, targets](std::size_t t) {
+				   random::stream gen(seed, t, nb_fits);
+				   build(trees[t], xs, targets, gen);
+				 },
+				 nb_threads);
+	++nb_fits;
+      }
+
+      double operator()(const INPUT& input) const {
+	if(trees.empty()) return 0;
+	auto x = as_array(input);
+	double sum = 0;
+	for(const auto& t : trees) {
+	  std::uint32_t k = 0;
+	  while(t[k].left != 0) k = (x[t[k].feature] <= t[k].threshold) ? t[k].left : t[k].right;
+	  sum += t[k].value;
+	}
+	return sum / trees.size();
+      }
+    };
+
+
+    /**
+     * This is a Q function, made of a regressor per command.
+     */
+    template<typename OBSERVATION, concepts::enumerable COMMAND, concepts::regressor<OBSERVATION> REGRESSOR>
+    class q_function {
+    public:
+
+      using observation_type = OBSERVATION;
+      using command_type     = COMMAND;
+      using regressor_type   = REGRESSOR;
+
+    private:
+
+      std::vector<REGRESSOR> regressors; // They are indexed by index_of(command).
+
+    public:
+
+      q_function()                             = delete;
+      q_function(const q_function&)            = default;
+      q_function& operator=(const q_function&) = default;
+      q_function(q_function&&)                 = default;
+      q_function& operator=(q_function&&)      = default;
+
+      /**
+       * Each command gets a copy of the prototype.
+       */
+      q_function(const REGRESSOR& prototype) : regressors(cardinal<COMMAND>, prototype) {}
+
+      REGRESSOR&       regressor(const COMMAND& command)       {return regressors[index_of(command)];}
+      const REGRESSOR& regressor(const COMMAND& command) const {return regressors[index_of(command)];}
+
+      double operator()(const OBSERVATION& observation, const COMMAND& command) const {return regressor(command)(observation);}
+
+      /**
+       * This returns the best command and its value.
+       */
+      std::pair<COMMAND, double> best(const OBSERVATION& observation) const {
+	std::size_t best_rank = 0;
+	double best_value = regressors[0](observation);
+	for(std::size_t a = 1; a < regressors.size(); ++a)
+	  if(double v = regressors[a](observation); v > best_value) {
+	    best_value = v;
+	    best_rank = a;
+	  }
+	return {value_of<COMMAND>(best_rank), best_value};
+      }
+    };
+
+
+    /**
+     * This is the greedy controller of a Q function, that must
+     * outlive it.
+     */
+    template<typename Q_FUNCTION>
+    class greedy {
+    private:
+      const Q_FUNCTION* q;
+
+    public:
+      greedy(const Q_FUNCTION& q) : q(&q) {}
+      typename Q_FUNCTION::command_type operator()(const typename Q_FUNCTION::observation_type& observation) const {return q->best(observation).first;}
+    };
+
+
+    /**
+     * This runs fitted Q-iterations over a dataset of transitions
+     * (e.g. a std::vector of gdyn::transition or a store::episodes),
+     * the report being the reward. The dataset is read once, the
+     * fitting starts from the current q.
+     *
+     * A transition is considered as absorbing when is_terminal() is
+     * true, i.e. when it has no next command: its target is the
+     * reward alone. The transitions thus have to be obtained by
+     * truncating orbits rather than commands (orbit | take(n + 1) or
+     * orbit | take(n) | transition), otherwise the last transition of
+     * each truncated episode has no next command and its target is
+     * not bootstrapped from Q(s', .).
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REGRESSOR, typename DATASET>
+    requires requires(const DATASET& dataset, std::size_t i) {
+      {dataset.size()} -> std::convertible_to<std::size_t>;
+      {dataset[i].observation} -> std::convertible_to<OBSERVATION>;
+      {dataset[i].command} -> std::convertible_to<COMMAND>;
+      {dataset[i].next_observation} -> std::convertible_to<OBSERVATION>;
+      {dataset[i].is_terminal()} -> std::convertible_to<bool>;
+    }
+    void iterate(q_function<OBSERVATION, COMMAND, REGRESSOR>& q, const DATASET& dataset, double gamma, unsigned int nb_iterations,
+		 unsigned int nb_threads = std::thread::hardware_concurrency()) {
+      std::size_t n = dataset.size();
+
+      // The transitions are gathered by command, so that each
+      // regressor gets contiguous inputs and targets.
+      constexpr std::size_t nb_commands = cardinal<COMMAND>;
+      std::array<std::size_t, nb_commands + 1> offsets {};
+      for(std::size_t i = 0; i < n; ++i) ++offsets[index_of(static_cast<COMMAND>(dataset[i].command)) + 1];
+      for(std::size_t a = 0; a < nb_commands; ++a) offsets[a + 1] += offsets[a];
+      std::vector<OBSERVATION> observations(n), next_observations(n);
+      std::vector<double> rewards(n), continues(n), targets(n);
+      auto position = offsets;
+      for(std::size_t i = 0; i < n; ++i) {
+	auto t = dataset[i];
+	std::size_t j = position[index_of(static_cast<COMMAND>(t.command))]++;
+	observations[j]      = t.observation;
+	next_observations[j] = t.next_observation;
+	rewards[j]           = static_cast<double>(t.report);
+	continues[j]         = t.is_terminal() ? 0. : 1.;
+      }
+
+      for(unsigned int it = 0; it < nb_iterations; ++it) {
+	details::for_each_block(n, (n + details::block_size - 1) / details::block_size,
+				[&](std::size_t, std::size_t begin, std::size_t end) {
+				  for(std::size_t i = begin; i < end; ++i)
+				    targets[i] = rewards[i] + (continues[i] != 0 ? gamma * q.best(next_observations[i]).second : 0.);
+				},
+				nb_threads);
+	for(std::size_t a = 0; a < nb_commands; ++a)
+	  if(offsets[a + 1] > offsets[a])
+	    q.regressor(value_of<COMMAND>(a)).fit(std::span<const OBSERVATION>(observations.data() + offsets[a], offsets[a + 1] - offsets[a]),
+						  std::span<const double>(targets.data() + offsets[a], offsets[a + 1] - offsets[a]),
+						  nb_threads);
+      }
+    }
+  }
+}
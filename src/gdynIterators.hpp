@@ -18,13 +18,25 @@ limitations under the License.
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <concepts>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <functional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynRandom.hpp>
 #include <gdynTransition.hpp>
 
 namespace gdyn {
@@ -71,6 +83,67 @@ namespace gdyn {
       
     
 
+    // iterator for the random_commands view. Commands are generated
+    // by blocks, from a counter-based stream, and then served from a
+    // buffer. The buffer is allocated once, and shared by the copies
+    // of the iterator, so that copying it is cheap. Since any block
+    // of the stream can be computed again, the buffer is only a cache
+    // of the block of the last dereferenced command: copies at
+    // different positions remain valid, but they must be used from
+    // the same thread.
+    template<concepts::enumerable COMMAND>
+    struct random_commands {
+      using value_type      = COMMAND;
+      using difference_type = std::ptrdiff_t;
+
+      static constexpr std::size_t block_size = 256; // This is a multiple of 4, the size of philox blocks.
+      
+    private:
+
+      struct buffer_type {
+	random::key_type key;
+	std::uint64_t orbit;
+	std::uint64_t block = std::numeric_limits<std::uint64_t>::max(); // The rank of the buffered block (none yet).
+	std::array<value_type, block_size> commands;
+
+	buffer_type(const random::key_type& key, std::uint64_t orbit) : key(key), orbit(orbit) {}
+
+	void fill(std::uint64_t b) {
+	  std::array<std::uint32_t, block_size> bits;
+	  std::uint64_t first = b * (block_size / 4); // The rank of the first philox block.
+	  random::philox::fill(bits, random::counter(orbit, std::uint32_t(first >> 32), std::uint32_t(first)), key);
+	  // This is Lemire's multiply-shift range reduction, that does not need any division.
+	  for(auto& x : bits) x = std::uint32_t((std::uint64_t(x) * cardinal<value_type>) >> 32);
+	  for(std::size_t i = 0; i < block_size; ++i) commands[i] = value_of<value_type>(bits[i]);
+	  block = b;
+	}
+      };
+
+      std::shared_ptr<buffer_type> buffer;
+      std::uint64_t pos = 0; // The rank of the current command in the stream.
+      
+    public:
+      
+      random_commands()                                  = delete;
+      random_commands(const random_commands&)            = default;
+      random_commands& operator=(const random_commands&) = default;
+      random_commands(random_commands&&)                 = default;
+      random_commands& operator=(random_commands&&)      = default;
+	
+      random_commands(std::uint64_t seed, std::uint64_t orbit) : buffer(std::make_shared<buffer_type>(random::key(seed), orbit)) {}
+	
+      auto& operator++()   {++pos; return *this;}
+      auto operator++(int) {auto res = *this; ++(*this); return res;}
+
+      value_type operator*() const {
+	if(std::uint64_t b = pos / block_size; b != buffer->block) buffer->fill(b);
+	return buffer->commands[pos % block_size];
+      }
+
+      bool operator==(terminal_t) const {return false;}
+    };
+    
+
     // This is for iterating on system orbits.
     template<concepts::system SYSTEM,
 	     concepts::command_iterator<typename SYSTEM::command_type> COMMAND_ITERATOR,
@@ -153,6 +226,200 @@ namespace gdyn {
       auto  operator++(int) {auto res = *this; ++(*this); return res;}   
     };
 
+    // This is for iterating on successive orbits of a system. When a
+    // terminal state is reached, the system is reset from a state
+    // generator and a new episode starts.
+    template<concepts::system SYSTEM,
+	     std::invocable STATE_GENERATOR,
+	     concepts::command_iterator<typename SYSTEM::command_type> COMMAND_ITERATOR,
+	     typename COMMAND_SENTINEL>
+    struct episodes {
+      
+    private:
+      SYSTEM* system = nullptr;
+      const STATE_GENERATOR* generate = nullptr;
+      COMMAND_ITERATOR it;
+      COMMAND_SENTINEL end;
+
+    public:
+
+      using difference_type = std::ptrdiff_t;
+
+      
+      struct value_type {
+	using observation_type = typename SYSTEM::observation_type;
+	using command_type     = typename SYSTEM::command_type;
+	using report_type      = typename SYSTEM::report_type;
+	observation_type            current_observation;
+	std::optional<command_type> next_command;
+	std::optional<report_type>  previous_report;
+	std::size_t                 episode = 0; //!< The rank of the episode the point belongs to.
+	
+	
+	value_type()                             = default;
+	value_type(const value_type&)            = default;
+	value_type& operator=(const value_type&) = default;
+	value_type(value_type&&)                 = default;
+	value_type& operator=(value_type&&)      = default;
+      };
+      
+    private:
+      
+      value_type value;
+      bool terminated = false;
+
+      void set_next_command() {
+	if(it == end || !(*system))
+	  value.next_command = std::nullopt;
+	else
+	  value.next_command = *it;
+      }
+      
+    public:
+      
+      episodes()                           = delete;
+      episodes(const episodes&)            = default;
+      episodes(episodes&&)                 = default;
+      episodes& operator=(const episodes&) = default;
+      episodes& operator=(episodes&&     ) = default;
+
+      // The system is expected to be already set to the initial state
+      // of the first episode, it has been used to get it.
+      episodes(SYSTEM& system, const STATE_GENERATOR& generate, COMMAND_ITERATOR it, COMMAND_SENTINEL end)
+	: system(&system), generate(&generate), it(it), end(end),
+	  value(), terminated() {
+	if(it == end)
+	  terminated = true;
+	else {
+	  value.current_observation = *system;
+	  set_next_command();
+	}
+      }
+      
+      bool operator==(terminal_t) const {return terminated;}
+      auto& operator*() const {return value;}
+      auto& operator++() {
+	if(value.next_command) { // We perform a transition within the current episode.
+	  value.previous_report = (*system)(*(value.next_command));
+	  value.current_observation = *(*system);
+	  ++it;
+	  set_next_command();
+	}
+	else if(it == end) // There are no more commands.
+	  terminated = true;
+	else { // We are in a terminal state, a new episode starts.
+	  *system = (*generate)();
+	  ++(value.episode);
+	  // The pending command was decided for the terminal state, so
+	  // the source is advanced for the first command of the new
+	  // episode to be decided from the new state. This consumes a
+	  // command of the source at each reset.
+	  ++it;
+	  value.previous_report = std::nullopt;
+	  value.current_observation = *(*system);
+	  set_next_command();
+	}
+	return *this;
+      }
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
+
+    // This is for iterating on the orbits of many systems at once,
+    // all of them being driven by a single batch controller. Each
+    // iteration step is a tick, where the controller is called once
+    // for all the systems that are not in a terminal state. The
+    // value is the current orbit point of each system whose orbit is
+    // not over. A std::length_error is thrown if the controller does
+    // not provide a command per running system.
+    template<concepts::system SYSTEM,
+	     concepts::batch_controller<typename SYSTEM::observation_type, typename SYSTEM::command_type> CONTROLLER>
+    struct batch_orbit {
+      
+    public:
+      
+      struct point_type {
+	using observation_type = typename SYSTEM::observation_type;
+	using command_type     = typename SYSTEM::command_type;
+	using report_type      = typename SYSTEM::report_type;
+	observation_type            current_observation;
+	std::optional<command_type> next_command;
+	std::optional<report_type>  previous_report;
+	std::size_t                 lane = 0; //!< The rank of the system the point belongs to.
+	
+	point_type()                             = default;
+	point_type(const point_type&)            = default;
+	point_type& operator=(const point_type&) = default;
+	point_type(point_type&&)                 = default;
+	point_type& operator=(point_type&&)      = default;
+      };
+
+      using value_type      = std::span<const point_type>;
+      using difference_type = std::ptrdiff_t;
+      
+    private:
+      
+      std::span<SYSTEM> systems;
+      CONTROLLER* controller = nullptr;
+      std::vector<point_type> points;
+      std::vector<typename SYSTEM::observation_type> observations;
+
+      // The controller is called for the systems that are not in a
+      // terminal state.
+      void decide() {
+	observations.clear();
+	for(const auto& point : points)
+	  if(systems[point.lane]) observations.push_back(point.current_observation);
+	if(observations.empty()) {
+	  for(auto& point : points) point.next_command = std::nullopt;
+	  return;
+	}
+	std::span<const typename SYSTEM::command_type> commands = (*controller)(std::span<const typename SYSTEM::observation_type>(observations));
+	if(commands.size() != observations.size())
+	  throw std::length_error("gdyn::iterators::batch_orbit : the controller must provide a command per running system");
+	auto command = commands.begin();
+	for(auto& point : points)
+	  if(systems[point.lane]) point.next_command = *(command++);
+	  else                    point.next_command = std::nullopt;
+      }
+      
+    public:
+      
+      batch_orbit()                              = delete;
+      batch_orbit(const batch_orbit&)            = default;
+      batch_orbit(batch_orbit&&)                 = default;
+      batch_orbit& operator=(const batch_orbit&) = default;
+      batch_orbit& operator=(batch_orbit&&     ) = default;
+
+      batch_orbit(std::span<SYSTEM> systems, CONTROLLER& controller)
+	: systems(systems), controller(&controller), points(systems.size()) {
+	observations.reserve(systems.size());
+	for(std::size_t lane = 0; lane < systems.size(); ++lane) {
+	  points[lane].lane = lane;
+	  points[lane].current_observation = *(systems[lane]);
+	}
+	decide();
+      }
+      
+      bool operator==(terminal_t) const {return points.empty();}
+      value_type operator*() const {return points;}
+      auto& operator++() {
+	// The systems whose orbit is over are removed, the others perform their transition.
+	std::size_t kept = 0;
+	for(auto& point : points)
+	  if(point.next_command) {
+	    auto& system = systems[point.lane];
+	    point.previous_report = system(*(point.next_command));
+	    point.current_observation = *system;
+	    if(&(points[kept]) != &point) points[kept] = std::move(point);
+	    ++kept;
+	  }
+	points.resize(kept);
+	decide();
+	return *this;
+      }
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
+
     template<concepts::orbit_iterator ORBIT_ITERATOR>
     using observation_t = typename ORBIT_ITERATOR::value_type::observation_type;
 				   
@@ -191,28 +458,455 @@ namespace gdyn {
       transition& operator=(const transition&) = default;
       transition& operator=(transition&&     ) = default;
 
-      transition(ORBIT_ITERATOR begin, ORBIT_SENTINEL end) : it(begin), end(end), value() {
-	if(it != end) {
+    private:
+
+      // This builds the first transition from the current position
+      // of it. Terminal points are skipped, since the orbit may
+      // restart after them (see iterators::episodes).
+      void start() {
+	value = std::nullopt;
+	while(it != end) {
 	  auto start = *(it++);
-	  if(it != end) 
+	  if(it == end)
+	    return;
+	  if(start.next_command) {
 	    value = make_transition(start, *it);
+	    return;
+	  }
 	}
       }
+
+    public:
+
+      transition(ORBIT_ITERATOR begin, ORBIT_SENTINEL end) : it(begin), end(end), value() {
+	start();
+      }
       
       bool operator==(terminal_t) const {return it == end || !value;}
       
       auto& operator++() {
-	++it;
-	if(it == end)
-	  value = std::nullopt;
-	else
-	  *value += *it; // We skip to the next transition.
+	if(value->is_terminal()) { // The orbit may go on with a new episode.
+	  ++it;
+	  start();
+	}
+	else {
+	  ++it;
+	  if(it == end)
+	    value = std::nullopt;
+	  else
+	    *value += *it; // We skip to the next transition.
+	}
 	return *this;
       }
       const auto& operator*() const {return *value;} 
       auto  operator++(int)         {auto res = *this; ++(*this); return res;}   
     };
 
+
+    // This is for iterating on the transitions of the systems driven
+    // by a batch orbit. The value gathers the transitions performed
+    // at the current tick.
+    template<typename BATCH_ORBIT_ITERATOR, typename BATCH_ORBIT_SENTINEL>
+    struct batch_transition {
+
+    private:
+
+      using point_type = typename std::iter_value_t<BATCH_ORBIT_ITERATOR>::value_type;
+      
+      BATCH_ORBIT_ITERATOR it;
+      BATCH_ORBIT_SENTINEL end;
+
+    public:
+
+      using transition_type = gdyn::transition<typename point_type::observation_type,
+					       typename point_type::command_type,
+					       typename point_type::report_type>;
+      using value_type      = std::span<const transition_type>;
+      using difference_type = std::ptrdiff_t;
+
+    private:
+      
+      std::vector<std::optional<point_type>> previous; // This is indexed by lanes.
+      std::vector<transition_type> transitions;
+
+      void remember() {
+	for(const auto& point : *it) {
+	  if(point.lane >= previous.size()) previous.resize(point.lane + 1);
+	  previous[point.lane] = point;
+	}
+      }
+
+      // We skip ticks until some transitions can be built.
+      void next_tick() {
+	transitions.clear();
+	while(transitions.empty() && it != end) {
+	  remember();
+	  if(++it == end) return;
+	  for(const auto& point : *it)
+	    if(point.lane < previous.size() && previous[point.lane] && previous[point.lane]->next_command)
+	      transitions.push_back(make_transition(*(previous[point.lane]), point));
+	}
+      }
+
+    public:
+      
+      batch_transition()                                   = delete;
+      batch_transition(const batch_transition&)            = default;
+      batch_transition(batch_transition&&)                 = default;
+      batch_transition& operator=(const batch_transition&) = default;
+      batch_transition& operator=(batch_transition&&     ) = default;
+
+      batch_transition(BATCH_ORBIT_ITERATOR begin, BATCH_ORBIT_SENTINEL end) : it(begin), end(end) {
+	next_tick();
+      }
+
+      bool operator==(terminal_t) const {return transitions.empty();}
+      value_type operator*() const {return transitions;}
+      auto& operator++()   {next_tick(); return *this;}
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
+
+
+    // This is for iterating on the orbit of a single lane of a batch
+    // orbit, as if it were the orbit of its system alone. The points
+    // of a tick are sorted by lane, so the one of the lane is found
+    // by a binary search. The lane is over when its point is not in
+    // the tick anymore.
+    template<typename BATCH_ORBIT_ITERATOR, typename BATCH_ORBIT_SENTINEL>
+    struct lane {
+
+    private:
+
+      BATCH_ORBIT_ITERATOR it;
+      BATCH_ORBIT_SENTINEL end;
+      std::size_t rank;
+
+    public:
+
+      using value_type      = typename std::iter_value_t<BATCH_ORBIT_ITERATOR>::value_type;
+      using difference_type = std::ptrdiff_t;
+
+    private:
+
+      std::optional<value_type> value;
+
+      void find() {
+	value = std::nullopt;
+	if(it == end) return;
+	auto points = *it;
+	auto found = std::ranges::lower_bound(points, rank, std::ranges::less(), [](const auto& point) {return point.lane;});
+	if(found != points.end() && found->lane == rank) value = *found;
+      }
+
+    public:
+
+      lane()                       = delete;
+      lane(const lane&)            = default;
+      lane(lane&&)                 = default;
+      lane& operator=(const lane&) = default;
+      lane& operator=(lane&&     ) = default;
+
+      lane(BATCH_ORBIT_ITERATOR begin, BATCH_ORBIT_SENTINEL end, std::size_t rank) : it(begin), end(end), rank(rank) {
+	find();
+      }
+
+      bool operator==(terminal_t) const {return !value;}
+      const auto& operator*() const {return *value;}
+      auto& operator++()    {++it; find(); return *this;}
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}
+    };
+
+
+    // This is for iterating on minibatches of transitions. The
+    // transition fields are copied into arrays allocated once, that
+    // are refilled for each batch.
+    template<typename TRANSITION_ITERATOR,
+	     typename TRANSITION_SENTINEL>
+    struct minibatch {
+
+    private:
+
+      using transition_type  = std::iter_value_t<TRANSITION_ITERATOR>;
+      using observation_type = std::remove_cvref_t<decltype(std::declval<transition_type>().observation)>;
+      using command_type     = std::remove_cvref_t<decltype(std::declval<transition_type>().command)>;
+      using report_type      = std::remove_cvref_t<decltype(std::declval<transition_type>().report)>;
+      
+      TRANSITION_ITERATOR it;
+      TRANSITION_SENTINEL end;
+      std::vector<observation_type>            observations;
+      std::vector<command_type>                commands;
+      std::vector<report_type>                 reports;
+      std::vector<observation_type>            next_observations;
+      std::vector<std::optional<command_type>> next_commands;
+      std::vector<std::uint8_t>                terminals;
+      std::size_t size = 0; // The number of transitions in the current batch.
+
+      // The last batch may be smaller.
+      void fill() {
+	for(size = 0; size < observations.size() && it != end; ++size, ++it) {
+	  const auto& t = *it;
+	  observations[size]      = t.observation;
+	  commands[size]          = t.command;
+	  reports[size]           = t.report;
+	  next_observations[size] = t.next_observation;
+	  next_commands[size]     = t.next_command;
+	  terminals[size]         = t.is_terminal();
+	}
+      }
+
+    public:
+
+      using value_type      = gdyn::minibatch<observation_type, command_type, report_type>;
+      using difference_type = std::ptrdiff_t;
+
+      minibatch()                            = delete;
+      minibatch(const minibatch&)            = default;
+      minibatch(minibatch&&)                 = default;
+      minibatch& operator=(const minibatch&) = default;
+      minibatch& operator=(minibatch&&     ) = default;
+
+      minibatch(TRANSITION_ITERATOR begin, TRANSITION_SENTINEL end, std::size_t batch_size)
+	: it(begin), end(end),
+	  observations(batch_size), commands(batch_size), reports(batch_size),
+	  next_observations(batch_size), next_commands(batch_size), terminals(batch_size) {
+	fill();
+      }
+
+      bool operator==(terminal_t) const {return size == 0;}
+      
+      // The batch refers to the iterator buffers, it is invalidated by ++.
+      value_type operator*() const {
+	return {{observations.data(), size}, {commands.data(), size}, {reports.data(), size},
+		{next_observations.data(), size}, {next_commands.data(), size}, {terminals.data(), size}};
+      }
+      auto& operator++()    {fill(); return *this;}
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
+
+
+    // This is for iterating on n-step transitions. The last n + 1
+    // orbit points are kept in a ring buffer.
+    template<concepts::orbit_iterator ORBIT_ITERATOR,
+	     typename ORBIT_SENTINEL>
+    struct n_step_transition {
+
+    private:
+
+      using point_type  = std::iter_value_t<ORBIT_ITERATOR>;
+      using report_type = decltype(std::declval<report_t<ORBIT_ITERATOR>>() * double());
+      
+      ORBIT_ITERATOR it;
+      ORBIT_SENTINEL end;
+      unsigned int n;
+      double gamma;
+      std::vector<point_type> ring;   // The size is n + 1.
+      std::size_t first    = 0;       // The rank in ring of the oldest point.
+      std::size_t size     = 0;       // The number of points in ring.
+      bool        flushing = false;   // The episode is over, the remaining points are emitted with less steps.
+
+    public:
+
+      using value_type = gdyn::n_step_transition<observation_t<ORBIT_ITERATOR>, command_t<ORBIT_ITERATOR>, report_type>;
+      using difference_type = std::ptrdiff_t;
+
+    private:
+
+      std::optional<value_type> value;
+
+      const point_type& at(std::size_t i) const {return ring[(first + i) % ring.size()];}
+
+      // This reads points until there are n + 1 of them, or until
+      // the episode is over, and builds the transition from the
+      // oldest point.
+      void fill() {
+	value = std::nullopt;
+	while(true) {
+	  while(!flushing && size < ring.size()) {
+	    if(it == end) {
+	      flushing = true;
+	      break;
+	    }
+	    auto& p = ring[(first + size++) % ring.size()];
+	    p = *it;
+	    ++it;
+	    if(!p.next_command) flushing = true; // Terminal state, the orbit may go on with a new episode.
+	  }
+	  if(size > 1) break;
+	  // There is no transition left in this episode.
+	  first = 0;
+	  size  = 0;
+	  if(it == end) return;
+	  flushing = false;
+	}
+	
+	std::size_t steps = size - 1;
+	report_type report = *(at(1).previous_report);
+	double discount = gamma;
+	for(std::size_t k = 2; k <= steps; ++k, discount *= gamma)
+	  report += discount * *(at(k).previous_report);
+	const auto& start = at(0);
+	const auto& last  = at(steps);
+	value = value_type {start.current_observation, *(start.next_command), report,
+			    last.current_observation, last.next_command, static_cast<unsigned int>(steps), discount};
+      }
+
+    public:
+      
+      n_step_transition()                                    = delete;
+      n_step_transition(const n_step_transition&)            = default;
+      n_step_transition(n_step_transition&&)                 = default;
+      n_step_transition& operator=(const n_step_transition&) = default;
+      n_step_transition& operator=(n_step_transition&&     ) = default;
+
+      n_step_transition(ORBIT_ITERATOR begin, ORBIT_SENTINEL end, unsigned int n, double gamma)
+	: it(begin), end(end), n(n), gamma(gamma), ring(n + 1) {
+	if(n == 0)
+	  throw std::invalid_argument("gdyn::iterators::n_step_transition : n must be positive");
+	fill();
+      }
+
+      bool operator==(terminal_t) const {return !value;}
+      const auto& operator*() const {return *value;}
+      auto& operator++() {
+	first = (first + 1) % ring.size();
+	--size;
+	fill();
+	return *this;
+      }
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
+
+
+    // This is for iterating on orbit points or transitions whose
+    // observations are normalized. The normalizer is updated with
+    // each observation read from the underlying range (once per
+    // element, whatever the number of dereferencings), unless it is
+    // frozen. For transitions, the next observation is pushed, as
+    // well as the observation of the transitions that start an
+    // episode, so that each observation is pushed once. Elements are
+    // read lazily, when the iterator is first compared, dereferenced
+    // or incremented, so that building an iterator pushes nothing.
+    template<typename ITERATOR,
+	     typename SENTINEL,
+	     typename NORMALIZER>
+    struct normalize {
+
+    private:
+
+      ITERATOR it;
+      SENTINEL end;
+      NORMALIZER* normalizer = nullptr;
+
+    public:
+
+      using value_type      = std::iter_value_t<ITERATOR>;
+      using difference_type = std::ptrdiff_t;
+
+    private:
+
+      mutable std::optional<value_type> value;
+      mutable bool fetched = false;
+      mutable bool episode_start = true; // Whether the next transition starts an episode.
+
+      void fetch() const {
+	if(fetched) return;
+	fetched = true;
+	if(it == end) {
+	  value = std::nullopt;
+	  return;
+	}
+	value = *it;
+	auto& v = *value;
+	if constexpr (requires {v.current_observation;}) {
+	  normalizer->push(v.current_observation);
+	  v.current_observation = (*normalizer)(v.current_observation);
+	}
+	else {
+	  if(episode_start) normalizer->push(v.observation);
+	  normalizer->push(v.next_observation);
+	  episode_start = v.is_terminal();
+	  v.observation      = (*normalizer)(v.observation);
+	  v.next_observation = (*normalizer)(v.next_observation);
+	}
+      }
+
+    public:
+
+      normalize()                            = delete;
+      normalize(const normalize&)            = default;
+      normalize(normalize&&)                 = default;
+      normalize& operator=(const normalize&) = default;
+      normalize& operator=(normalize&&     ) = default;
+
+      normalize(ITERATOR begin, SENTINEL end, NORMALIZER& normalizer)
+	: it(begin), end(end), normalizer(&normalizer) {}
+
+      bool operator==(terminal_t) const {fetch(); return !value;}
+      const auto& operator*() const {fetch(); return *value;}
+      auto& operator++()    {fetch(); ++it; fetched = false; return *this;}
+      auto  operator++(int) {fetch(); auto res = *this; ++(*this); return res;}   
+    };
+
+
+    // This is for iterating on the histories of an orbit, i.e. the
+    // last k orbit points of the current episode. The points are
+    // written twice in a buffer of size 2k, at ranks i and i + k, so
+    // that the last k points are always contiguous in the buffer.
+    template<concepts::orbit_iterator ORBIT_ITERATOR,
+	     typename ORBIT_SENTINEL>
+    struct history {
+
+    private:
+
+      using point_type = std::iter_value_t<ORBIT_ITERATOR>;
+      
+      ORBIT_ITERATOR it;
+      ORBIT_SENTINEL end;
+      std::size_t k;
+      std::vector<point_type> buffer; // The size is 2k.
+      std::size_t head = 0;           // The rank where the next point is written.
+      std::size_t size = 0;           // The number of points in the current history.
+      bool done = false;
+
+      void read() {
+	if(it == end) {
+	  done = true;
+	  return;
+	}
+	const auto& p = *it;
+	if(!p.previous_report) { // A new episode starts.
+	  head = 0;
+	  size = 0;
+	}
+	buffer[head] = p;
+	buffer[head + k] = p;
+	head = (head + 1) % k;
+	size = std::min(size + 1, k);
+      }
+
+    public:
+
+      using value_type      = std::span<const point_type>;
+      using difference_type = std::ptrdiff_t;
+
+      history()                          = delete;
+      history(const history&)            = default;
+      history(history&&)                 = default;
+      history& operator=(const history&) = default;
+      history& operator=(history&&     ) = default;
+
+      history(ORBIT_ITERATOR begin, ORBIT_SENTINEL end, std::size_t k)
+	: it(begin), end(end), k(k), buffer(2 * k) {
+	read();
+      }
+
+      bool operator==(terminal_t) const {return done;}
+
+      // The history refers to the iterator buffer, it is invalidated by ++.
+      value_type operator*() const {return {buffer.data() + head + k - size, size};}
+      auto& operator++()    {++it; read(); return *this;}
+      auto  operator++(int) {auto res = *this; ++(*this); return res;}   
+    };
     
   }
 }
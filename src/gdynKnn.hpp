@@ -0,0 +1,401 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+#include <gdynParallel.hpp>
+
+// This provides nearest neighbour search over continuous values
+// (reflected structures, see gdyn::fields), e.g. the observations of
+// a transition dataset, so that non-parametric agents do not scan
+// the whole dataset for each decision.
+//
+// The index is a k-d tree. Each node splits its points at the median
+// of the field where they are the most spread, so the tree is
+// balanced and stored implicitly (the children of node h are 2h+1
+// and 2h+2). The nodes of a level are independent, they are split in
+// parallel.
+//
+// Distances are Euclidean, after each field has been multiplied by a
+// scale (e.g. the inverse of its range), since the fields of an
+// observation usually have different units.
+
+namespace gdyn {
+  namespace knn {
+
+    /**
+     * A neighbour is identified by its rank in the values the tree
+     * has been built from.
+     */
+    struct neighbour {
+      std::size_t index;
+      double distance;
+      bool operator<(const neighbour& other) const {return distance < other.distance;}
+    };
+
+    template<concepts::reflected T>
+    class tree {
+    public:
+
+      static constexpr std::size_t dim = nb_fields<T>;
+      using input_type = T;
+      using point_type = std::array<double, dim>;
+
+      static constexpr std::size_t default_leaf_size = 8;
+
+      static point_type unit_scale() {
+	point_type res;
+	res.fill(1.);
+	return res;
+      }
+
+    private:
+
+      point_type scale;
+      std::size_t leaf_size;
+      std::vector<point_type>   points;       // The scaled points, in the tree order.
+      std::vector<std::size_t>  ranks;        // ranks[i] is the rank of points[i] in the construction values.
+      std::vector<unsigned int> split_field;  // For each inner node.
+      std::vector<double>       split_value;
+
+      struct node {
+	std::size_t heap;
+	std::size_t first;
+	std::size_t last;
+      };
+
+      static double distance2(const point_type& a, const point_type& b) {
+	double res = 0;
+	for(std::size_t i = 0; i < dim; ++i) {
+	  double d = a[i] - b[i];
+	  res += d * d;
+	}
+	return res;
+      }
+
+      point_type scaled(const T& value) const {
+	auto res = as_array(value);
+	for(std::size_t i = 0; i < dim; ++i) res[i] *= scale[i];
+	return res;
+      }
+
+      bool is_leaf(std::size_t first, std::size_t last) const {return last - first <= leaf_size;}
+
+      void build(const std::vector<point_type>& raw, unsigned int nb_threads) {
+	std::size_t n = raw.size();
+	ranks.resize(n);
+	std::iota(ranks.begin(), ranks.end(), 0);
+
+	std::vector<node> level;
+	if(!is_leaf(0, n)) level.push_back({0, 0, n});
+	while(!level.empty()) {
+	  split_field.resize(level.back().heap + 1);
+	  split_value.resize(level.back().heap + 1);
+	  parallel::for_each_index(level.size(),
+				   [this, &raw, &level](std::size_t k) {
+				     auto [h, first, last] = level[k];
+				     point_type lo = raw[ranks[first]], hi = lo;
+				     for(std::size_t i = first + 1; i < last; ++i)
+				       for(std::size_t j = 0; j < dim; ++j) {
+					 lo[j] = std::min(lo[j], raw[ranks[i]][j]);
+					 hi[j] = std::max(hi[j], raw[ranks[i]][j]);
+				       }
+				     unsigned int f = 0;
+				     for(unsigned int j = 1; j < dim; ++j)
+				       if(hi[j] - lo[j] > hi[f] - lo[f]) f = j;
+				     std::size_t middle = first + (last - first) / 2;
+				     std::nth_element(ranks.begin() + first, ranks.begin() + middle, ranks.begin() + last,
+						      [&raw, f](std::size_t i, std::size_t j) {return raw[i][f] < raw[j][f];});
+				     split_field[h] = f;
+				     split_value[h] = raw[ranks[middle]][f];
+				   },
+				   nb_threads);
+	  std::vector<node> next;
+	  for(auto [h, first, last] : level) {
+	    std::size_t middle = first + (last - first) / 2;
+	    if(!is_leaf(first, middle)) next.push_back({2 * h + 1, first, middle});
+	    if(!is_leaf(middle, last))  next.push_back({2 * h + 2, middle, last});
+	  }
+	  level = std::move(next);
+	}
+
+	points.resize(n);
+	parallel::for_each_index((n + 1023) / 1024,
+				 [this, &raw, n](std::size_t b) {
+				   for(std::size_t i = b * 1024; i < std::min(n, (b + 1) * 1024); ++i) points[i] = raw[ranks[i]];
+				 },
+				 nb_threads);
+      }
+
+      // out is a max-heap on the squared distances.
+      void search(std::size_t h, std::size_t first, std::size_t last, const point_type& q, std::size_t k, double shrink, std::vector<neighbour>& out) const {
+	if(is_leaf(first, last)) {
+	  for(std::size_t i = first; i < last; ++i) {
+	    double d = distance2(q, points[i]);
+	    if(out.size() < k) {
+	      out.push_back({i, d});
+	      std::push_heap(out.begin(), out.end());
+	    }
+	    else if(d < out.front().distance) {
+	      std::pop_heap(out.begin(), out.end());
+	      out.back() = {i, d};
+	      std::push_heap(out.begin(), out.end());
+	    }
+	  }
+	  return;
+	}
+	std::size_t middle = first + (last - first) / 2;
+	double diff = q[split_field[h]] - split_value[h];
+	if(diff < 0) {
+	  search(2 * h + 1, first, middle, q, k, shrink, out);
+	  if(out.size() < k || diff * diff < out.front().distance * shrink) search(2 * h + 2, middle, last, q, k, shrink, out);
+	}
+	else {
+	  search(2 * h + 2, middle, last, q, k, shrink, out);
+	  if(out.size() < k || diff * diff < out.front().distance * shrink) search(2 * h + 1, first, middle, q, k, shrink, out);
+	}
+      }
+
+      void search(std::size_t h, std::size_t first, std::size_t last, const point_type& q, double radius2, std::vector<neighbour>& out) const {
+	if(is_leaf(first, last)) {
+	  for(std::size_t i = first; i < last; ++i)
+	    if(double d = distance2(q, points[i]); d <= radius2) out.push_back({i, d});
+	  return;
+	}
+	std::size_t middle = first + (last - first) / 2;
+	double diff = q[split_field[h]] - split_value[h];
+	if(diff < 0 || diff * diff <= radius2) search(2 * h + 1, first, middle, q, radius2, out);
+	if(diff >= 0 || diff * diff <= radius2) search(2 * h + 2, middle, last, q, radius2, out);
+      }
+
+      // This sorts the neighbours and sets their actual index and distance.
+      void finish(std::vector<neighbour>& out) const {
+	std::sort(out.begin(), out.end());
+	for(auto& n : out) n = {ranks[n.index], std::sqrt(n.distance)};
+      }
+
+    public:
+
+      tree()                       = delete;
+      tree(const tree&)            = default;
+      tree& operator=(const tree&) = default;
+      tree(tree&&)                 = default;
+      tree& operator=(tree&&)      = default;
+
+      /**
+       * @param values The values are copied (scaled) into the tree.
+       * @param scale Each field is multiplied by its scale before computing distances.
+       */
+      tree(std::span<const T> values, const point_type& scale = unit_scale(), std::size_t leaf_size = default_leaf_size,
+	   unsigned int nb_threads = std::thread::hardware_concurrency())
+	: scale(scale), leaf_size(std::max(leaf_size, std::size_t(1))) {
+	std::vector<point_type> raw(values.size());
+	parallel::for_each_index((values.size() + 1023) / 1024,
+				 [this, &raw, values](std::size_t b) {
+				   for(std::size_t i = b * 1024; i < std::min(values.size(), (b + 1) * 1024); ++i) raw[i] = scaled(values[i]);
+				 },
+				 nb_threads);
+	build(raw, nb_threads);
+      }
+
+      std::size_t size() const {return points.size();}
+
+      /**
+       * This writes in out the k nearest neighbours of query (or all
+       * the values if there are less than k), sorted by increasing
+       * distance. With a positive epsilon, the search is approximate:
+       * the i-th returned neighbour is at most (1 + epsilon) times
+       * farther than the actual i-th nearest one, but far fewer nodes
+       * are visited.
+       */
+      void nearest(const T& query, std::size_t k, std::vector<neighbour>& out, double epsilon = 0) const {
+	out.clear();
+	if(k == 0 || points.empty()) return;
+	if(epsilon < 0)
+	  throw std::invalid_argument("gdyn::knn::tree::nearest : epsilon must not be negative");
+	search(0, 0, points.size(), scaled(query), k, 1 / ((1 + epsilon) * (1 + epsilon)), out);
+	finish(out);
+      }
+
+      std::vector<neighbour> nearest(const T& query, std::size_t k, double epsilon = 0) const {
+	std::vector<neighbour> res;
+	res.reserve(k);
+	nearest(query, k, res, epsilon);
+	return res;
+      }
+
+      /**
+       * This writes in out all the values whose distance to query is
+       * at most radius, sorted by increasing distance.
+       */
+      void within(const T& query, double radius, std::vector<neighbour>& out) const {
+	out.clear();
+	if(points.empty() || radius < 0) return;
+	search(0, 0, points.size(), scaled(query), radius * radius, out);
+	finish(out);
+      }
+
+      std::vector<neighbour> within(const T& query, double radius) const {
+	std::vector<neighbour> res;
+	within(query, radius, res);
+	return res;
+      }
+    };
+
+
+    /**
+     * This controller returns the most frequent command among the ones
+     * of the k nearest observations (ties are won by the nearest
+     * one). The index and the commands, where commands[i] is the
+     * command of the i-th indexed observation, must outlive it.
+     */
+    template<concepts::reflected OBSERVATION, concepts::enumerable COMMAND>
+    class controller {
+    private:
+      const tree<OBSERVATION>* index;
+      std::span<const COMMAND> commands;
+      std::size_t k;
+      double epsilon;
+
+    public:
+
+      controller(const tree<OBSERVATION>& index, std::span<const COMMAND> commands, std::size_t k, double epsilon = 0)
+	: index(&index), commands(commands), k(k), epsilon(epsilon) {
+	if(commands.size() != index.size())
+	  throw std::invalid_argument("gdyn::knn::controller : a command per indexed observation is required");
+	if(k == 0 || index.size() == 0)
+	  throw std::invalid_argument("gdyn::knn::controller : k and the index size must be positive");
+      }
+
+      COMMAND operator()(const OBSERVATION& observation) const {
+	auto neighbours = index->nearest(observation, k, epsilon);
+	std::array<std::size_t, cardinal<COMMAND>> votes {};
+	for(const auto& n : neighbours) ++votes[index_of(commands[n.index])];
+	std::size_t max_votes = *std::ranges::max_element(votes);
+	// neighbours are sorted by distance, the nearest tied command wins.
+	for(const auto& n : neighbours)
+	  if(std::size_t rank = index_of(commands[n.index]); votes[rank] == max_votes) return value_of<COMMAND>(rank);
+	return value_of<COMMAND>(index_of(commands[neighbours.front().index]));
+      }
+    };
+
+
+    /**
+     * This is a model of a system learnt from a dataset of
+     * transitions (e.g. a std::vector of gdyn::transition or a
+     * store::episodes). For an observation and a command, it averages
+     * the k nearest transitions with that command: the predicted next
+     * observation is the observation plus their mean displacement, the
+     * report is their mean report, and terminal is the proportion of
+     * terminal ones.
+     */
+    template<concepts::reflected OBSERVATION, concepts::enumerable COMMAND>
+    class predictor {
+    public:
+
+      using observation_type = OBSERVATION;
+      using command_type     = COMMAND;
+
+      struct prediction {
+	OBSERVATION next_observation;
+	double report;
+	double terminal;
+      };
+
+    private:
+
+      static constexpr std::size_t dim = nb_fields<OBSERVATION>;
+
+      struct outcome {
+	std::array<double, dim> displacement;
+	double report;
+	double terminal;
+      };
+
+      std::vector<tree<OBSERVATION>> trees;       // One per command.
+      std::vector<std::vector<outcome>> outcomes; // outcomes[a][i] is the outcome of the i-th transition of trees[a].
+      std::size_t k;
+      double epsilon;
+
+    public:
+
+      template<typename DATASET>
+      requires requires(const DATASET& dataset, std::size_t i) {
+	{dataset.size()} -> std::convertible_to<std::size_t>;
+	{dataset[i].observation} -> std::convertible_to<OBSERVATION>;
+	{dataset[i].command} -> std::convertible_to<COMMAND>;
+	{dataset[i].next_observation} -> std::convertible_to<OBSERVATION>;
+	{static_cast<double>(dataset[i].report)};
+	{dataset[i].is_terminal()} -> std::convertible_to<bool>;
+      }
+      predictor(const DATASET& dataset, std::size_t k, double epsilon = 0,
+		const typename tree<OBSERVATION>::point_type& scale = tree<OBSERVATION>::unit_scale(),
+		unsigned int nb_threads = std::thread::hardware_concurrency())
+	: outcomes(cardinal<COMMAND>), k(k), epsilon(epsilon) {
+	if(k == 0)
+	  throw std::invalid_argument("gdyn::knn::predictor : k must be positive");
+	std::vector<std::vector<OBSERVATION>> observations(cardinal<COMMAND>);
+	for(std::size_t i = 0; i < dataset.size(); ++i) {
+	  auto t = dataset[i];
+	  std::size_t a = index_of(static_cast<COMMAND>(t.command));
+	  auto from = as_array(static_cast<OBSERVATION>(t.observation));
+	  auto to   = as_array(static_cast<OBSERVATION>(t.next_observation));
+	  outcome o {{}, static_cast<double>(t.report), t.is_terminal() ? 1. : 0.};
+	  for(std::size_t j = 0; j < dim; ++j) o.displacement[j] = to[j] - from[j];
+	  observations[a].push_back(t.observation);
+	  outcomes[a].push_back(o);
+	}
+	trees.reserve(cardinal<COMMAND>);
+	for(const auto& obs : observations) trees.emplace_back(std::span<const OBSERVATION>(obs), scale, tree<OBSERVATION>::default_leaf_size, nb_threads);
+      }
+
+      /**
+       * This throws if there is no transition with that command.
+       */
+      prediction operator()(const OBSERVATION& observation, const COMMAND& command) const {
+	std::size_t a = index_of(command);
+	if(trees[a].size() == 0)
+	  throw std::runtime_error("gdyn::knn::predictor : no transition with that command");
+	auto neighbours = trees[a].nearest(observation, k, epsilon);
+	auto x = as_array(observation);
+	double report = 0, terminal = 0, w = 1. / neighbours.size();
+	for(const auto& n : neighbours) {
+	  const auto& o = outcomes[a][n.index];
+	  for(std::size_t j = 0; j < dim; ++j) x[j] += w * o.displacement[j];
+	  report   += w * o.report;
+	  terminal += w * o.terminal;
+	}
+	return {from_array<OBSERVATION>(x), report, terminal};
+      }
+    };
+  }
+}
@@ -0,0 +1,210 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <ranges>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynParallel.hpp>
+#include <gdynRandom.hpp>
+#include <gdynRanges.hpp>
+
+// For a deterministic system, an orbit is entirely defined by its
+// initial state and its commands. Rather than storing the orbit
+// points, we can store a command log, and recompute the orbit when
+// it is needed. For a stochastic system, the seed of its random
+// generator has to be logged as well. This only works if the system
+// draws its random values from a gdyn::random::stream built from
+// that seed, that it does not share with the system of any other
+// episode: replaying then draws the same values in the same order.
+//
+// Commands are enumerable, so each one is stored as its rank in
+// enumerable<command_type>::values, with as few bits as possible.
+
+namespace gdyn {
+  namespace log {
+
+    /**
+     * This is the log of an episode: an initial state, a seed, and
+     * the successive commands applied to the system.
+     */
+    template<concepts::system SYSTEM>
+    requires concepts::enumerable<typename SYSTEM::command_type>
+    class episode {
+    public:
+
+      using system_type  = SYSTEM;
+      using state_type   = typename SYSTEM::state_type;
+      using command_type = typename SYSTEM::command_type;
+
+      // The number of bits used for storing a command. Commands do
+      // not overlap two words, so that reading one is a shift and a
+      // mask.
+      static constexpr unsigned int nb_bits  = std::max(1, static_cast<int>(std::bit_width(cardinal<command_type> - 1)));
+      static constexpr std::size_t  per_word = 64 / nb_bits;
+      static constexpr std::uint64_t mask    = (std::uint64_t(1) << nb_bits) - 1;
+
+      state_type    initial_state {};
+      std::uint64_t seed = 0; // Meaningful for stochastic systems only.
+
+    private:
+
+      std::vector<std::uint64_t> words;
+      std::size_t nb_commands = 0;
+
+    public:
+
+      episode()                          = default;
+      episode(const episode&)            = default;
+      episode& operator=(const episode&) = default;
+      episode(episode&&)                 = default;
+      episode& operator=(episode&&)      = default;
+
+      episode(const state_type& initial_state, std::uint64_t seed = 0) : initial_state(initial_state), seed(seed) {}
+
+      void push_back(const command_type& command) {
+	if(nb_commands % per_word == 0) words.push_back(0);
+	words.back() |= std::uint64_t(index_of(command)) << ((nb_commands % per_word) * nb_bits);
+	++nb_commands;
+      }
+
+      void clear() {words.clear(); nb_commands = 0;}
+
+      std::size_t size()  const {return nb_commands;}
+      bool        empty() const {return nb_commands == 0;}
+
+      command_type operator[](std::size_t i) const {
+	return value_of<command_type>((words[i / per_word] >> ((i % per_word) * nb_bits)) & mask);
+      }
+
+      /**
+       * The number of bytes taken by the log content.
+       */
+      std::size_t memory_size() const {
+	return sizeof(state_type) + sizeof(seed) + sizeof(nb_commands) + words.size() * sizeof(std::uint64_t);
+      }
+
+      /**
+       * This is a range of the logged commands. It refers to the
+       * episode, that must outlive it.
+       */
+      auto commands() const {
+	return std::views::iota(std::size_t(0), nb_commands)
+	  | std::views::transform([this](std::size_t i) {return (*this)[i];});
+      }
+
+      /**
+       * This writes the log in binary form. The byte order is the
+       * one of the machine.
+       */
+      void write(std::ostream& os) const requires std::is_trivially_copyable_v<state_type> {
+	os.write(reinterpret_cast<const char*>(&initial_state), sizeof(state_type));
+	os.write(reinterpret_cast<const char*>(&seed),          sizeof(seed));
+	os.write(reinterpret_cast<const char*>(&nb_commands),   sizeof(nb_commands));
+	os.write(reinterpret_cast<const char*>(words.data()),   words.size() * sizeof(std::uint64_t));
+      }
+
+      /**
+       * This reads a log written by write. It throws a
+       * std::runtime_error if the stream ends too early.
+       */
+      void read(std::istream& is) requires std::is_trivially_copyable_v<state_type> {
+	is.read(reinterpret_cast<char*>(&initial_state), sizeof(state_type));
+	is.read(reinterpret_cast<char*>(&seed),          sizeof(seed));
+	is.read(reinterpret_cast<char*>(&nb_commands),   sizeof(nb_commands));
+	if(!is)
+	  throw std::runtime_error("gdyn::log::episode::read : truncated header");
+	words.resize((nb_commands + per_word - 1) / per_word);
+	is.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(std::uint64_t));
+	if(!is)
+	  throw std::runtime_error("gdyn::log::episode::read : truncated commands");
+      }
+    };
+
+    /**
+     * This sets the system to initial_state, feeds it with the
+     * commands until they end or the system reaches a terminal
+     * state, and returns the log of that episode. The system is left
+     * in its final state. For a stochastic system, seed is the one of
+     * the gdyn::random::stream it draws from, that must be fresh.
+     */
+    template<concepts::system SYSTEM, std::ranges::input_range COMMANDS>
+    episode<SYSTEM> record(SYSTEM& system, const typename SYSTEM::state_type& initial_state, COMMANDS&& commands, std::uint64_t seed = 0) {
+      episode<SYSTEM> res(initial_state, seed);
+      system = initial_state;
+      for(const auto& point : std::forward<COMMANDS>(commands) | views::orbit(system))
+	if(point.next_command) res.push_back(*(point.next_command));
+      return res;
+    }
+
+    /**
+     * This sets the system to the initial state of the episode, and
+     * returns the orbit obtained by feeding it with the logged
+     * commands. A stochastic system has to draw from a fresh
+     * gdyn::random::stream(log.seed) for the orbit to be the
+     * recorded one. The episode must outlive the orbit.
+     */
+    template<concepts::system SYSTEM>
+    auto replay(SYSTEM& system, const episode<SYSTEM>& log) {
+      system = log.initial_state;
+      return log.commands() | views::orbit(system);
+    }
+
+    /**
+     * This replays each episode of the logs, from nb_threads
+     * threads. For each episode, a gdyn::random::stream is built from
+     * the episode seed, and the system is built by
+     * make_system(stream). A stochastic system must draw its random
+     * values from that stream, so that each replay reproduces the
+     * recorded orbit without sharing a generator with the other
+     * threads. A deterministic system may ignore it. Then
+     * process(i, orbit) is called with the orbit of the i-th
+     * episode. process must be safe to call concurrently.
+     */
+    template<typename MAKE_SYSTEM, std::ranges::random_access_range LOGS, typename PROCESS>
+    requires std::invocable<const MAKE_SYSTEM&, random::stream&> &&
+    concepts::system<std::invoke_result_t<const MAKE_SYSTEM&, random::stream&>> &&
+    std::ranges::sized_range<const LOGS> &&
+    std::same_as<std::ranges::range_value_t<LOGS>, episode<std::invoke_result_t<const MAKE_SYSTEM&, random::stream&>>>
+    void replay(const MAKE_SYSTEM& make_system, const LOGS& logs, const PROCESS& process,
+		unsigned int nb_threads = std::thread::hardware_concurrency()) {
+      parallel::for_each_index(std::ranges::size(logs),
+			       [&make_system, &logs, &process](std::size_t i) {
+				 const auto& log = std::ranges::begin(logs)[i];
+				 random::stream gen(log.seed);
+				 auto system = make_system(gen);
+				 process(i, replay(system, log));
+			       },
+			       nb_threads);
+    }
+  }
+}
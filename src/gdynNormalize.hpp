@@ -0,0 +1,142 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <gdynConcepts.hpp>
+#include <gdynFields.hpp>
+
+// A normalizer keeps the running mean and variance of each field of
+// the values it is fed with (Welford's algorithm), and rescales
+// values so that their fields have a null mean and a unit variance.
+// The statistics of all the fields are updated together, in loops
+// over arrays that the compiler can vectorize.
+//
+// Normalizers fed by different threads can be merged with += (this
+// is the pairwise update of Chan et al.), the result being the one
+// that a single normalizer fed with all the values would have.
+//
+// Once frozen, a normalizer is not updated anymore, so that it can be
+// shared by several threads (see views::normalize).
+
+namespace gdyn {
+
+  template<concepts::reflected T>
+  class normalizer {
+  public:
+
+    static constexpr std::size_t dim = nb_fields<T>;
+    using value_type = T;
+    using array_type = std::array<double, dim>;
+
+  private:
+
+    std::uint64_t n = 0;
+    array_type m   {};  // The means.
+    array_type m2  {};  // The sums of the squared deviations to the mean.
+    double epsilon = 1e-8;
+    bool is_frozen = false;
+
+  public:
+
+    normalizer()                             = default;
+    normalizer(const normalizer&)            = default;
+    normalizer& operator=(const normalizer&) = default;
+    normalizer(normalizer&&)                 = default;
+    normalizer& operator=(normalizer&&)      = default;
+
+    /**
+     * @param epsilon This is added to the variances before scaling, so that constant fields do not blow up.
+     */
+    normalizer(double epsilon) : epsilon(epsilon) {}
+
+    /**
+     * This updates the statistics with value, unless the normalizer
+     * is frozen.
+     */
+    void push(const T& value) {
+      if(is_frozen) return;
+      auto x = as_array(value);
+      ++n;
+      double w = 1. / n;
+      for(std::size_t i = 0; i < dim; ++i) {
+	double d = x[i] - m[i];
+	m[i]  += w * d;
+	m2[i] += d * (x[i] - m[i]);
+      }
+    }
+
+    /**
+     * This merges the statistics of other into this one (even if
+     * this one is frozen).
+     */
+    normalizer& operator+=(const normalizer& other) {
+      if(other.n == 0) return *this;
+      std::uint64_t total = n + other.n;
+      double wa = static_cast<double>(n) / total, wb = static_cast<double>(other.n) / total;
+      double wab = static_cast<double>(n) * wb;
+      for(std::size_t i = 0; i < dim; ++i) {
+	double d = other.m[i] - m[i];
+	m[i]  = wa * m[i] + wb * other.m[i];
+	m2[i] += other.m2[i] + d * d * wab;
+      }
+      n = total;
+      return *this;
+    }
+
+    void freeze(bool frozen = true) {is_frozen = frozen;}
+    bool frozen() const {return is_frozen;}
+
+    void clear() {
+      n  = 0;
+      m  = {};
+      m2 = {};
+    }
+
+    /**
+     * The number of values the statistics are computed from.
+     */
+    std::uint64_t count() const {return n;}
+
+    const array_type& mean() const {return m;}
+
+    array_type variance() const {
+      array_type res {};
+      if(n > 0)
+	for(std::size_t i = 0; i < dim; ++i) res[i] = m2[i] / n;
+      return res;
+    }
+
+    /**
+     * This returns the normalized value. Values are returned unchanged
+     * as long as no value has been pushed.
+     */
+    T operator()(const T& value) const {
+      if(n == 0) return value;
+      auto x = as_array(value);
+      double w = 1. / n;
+      for(std::size_t i = 0; i < dim; ++i) x[i] = (x[i] - m[i]) / std::sqrt(m2[i] * w + epsilon);
+      return from_array<T>(x);
+    }
+  };
+}
@@ -0,0 +1,396 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gdyn {
+  namespace parallel {
+
+    // Let us avoid false sharing between atomic variables written by
+    // different threads.
+    inline constexpr std::size_t cache_line_size = 64;
+
+    // #########
+    // #       #
+    // # Loops #
+    // #       #
+    // #########
+
+    /**
+     * This calls f(i) for i in [0, size), from nb_threads threads. The
+     * indices are handed out one at a time, so that threads with
+     * cheap calls do not wait for the ones with expensive calls. The
+     * function returns when all the calls are done. f must be safe to
+     * call concurrently with different indices, and it must not throw.
+     */
+    template<std::invocable<std::size_t> F>
+    void for_each_index(std::size_t size, const F& f, unsigned int nb_threads = std::thread::hardware_concurrency()) {
+      nb_threads = static_cast<unsigned int>(std::min<std::size_t>(std::max(nb_threads, 1u), size));
+      if(nb_threads <= 1) {
+	for(std::size_t i = 0; i < size; ++i) f(i);
+	return;
+      }
+      std::atomic<std::size_t> next {0};
+      auto work = [&next, &f, size]() {
+	for(auto i = next.fetch_add(1, std::memory_order_relaxed); i < size; i = next.fetch_add(1, std::memory_order_relaxed))
+	  f(i);
+      };
+      std::vector<std::jthread> threads;
+      for(unsigned int t = 1; t < nb_threads; ++t) threads.emplace_back(work);
+      work();
+    }
+
+    // #########
+    // #       #
+    // # Queue #
+    // #       #
+    // #########
+
+    /**
+     * This is a bounded lock-free queue, where many threads can push
+     * values, while a single thread pops them. This is the
+     * D. Vyukov's bounded queue, where each cell holds a sequence
+     * number telling whether it can be written or read.
+     *
+     * This is typically used to send transitions from several actor
+     * threads to a single learner thread.
+     */
+    template<std::default_initializable T>
+    class mpsc_queue {
+    private:
+
+      struct alignas(cache_line_size) cell {
+	std::atomic<std::size_t> sequence;
+	T value;
+      };
+
+      std::size_t mask;
+      std::unique_ptr<cell[]> cells;
+      alignas(cache_line_size) std::atomic<std::size_t> push_position {0};
+      alignas(cache_line_size) std::size_t pop_position {0}; // Only the consumer thread reads and writes it.
+
+    public:
+
+      using value_type = T;
+
+      mpsc_queue()                              = delete;
+      mpsc_queue(const mpsc_queue&)             = delete;
+      mpsc_queue& operator=(const mpsc_queue&)  = delete;
+
+      /**
+       * @param capacity The actual capacity is the next power of 2.
+       */
+      mpsc_queue(std::size_t capacity)
+	: mask(std::bit_ceil(std::max(capacity, std::size_t(2))) - 1),
+	  cells(new cell[mask + 1]) {
+	for(std::size_t i = 0; i <= mask; ++i)
+	  cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      std::size_t capacity() const {return mask + 1;}
+
+      /**
+       * This can be called from any thread. It returns false if the
+       * queue is full.
+       */
+      bool try_push(const T& value) {
+	cell* c;
+	std::size_t position = push_position.load(std::memory_order_relaxed);
+	while(true) {
+	  c = &(cells[position & mask]);
+	  std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+	  auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+	  if(diff == 0) { // The cell is free, let us try to book it.
+	    if(push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+	      break;
+	  }
+	  else if(diff < 0) // The cell still holds a value from the previous lap.
+	    return false;
+	  else // Another producer has booked the cell.
+	    position = push_position.load(std::memory_order_relaxed);
+	}
+	c->value = value;
+	c->sequence.store(position + 1, std::memory_order_release);
+	return true;
+      }
+
+      /**
+       * This waits for room in the queue. It returns false if a stop
+       * has been requested meanwhile, the value is not pushed in that
+       * case.
+       */
+      bool push(const T& value, std::stop_token stop = {}) {
+	while(!try_push(value)) {
+	  if(stop.stop_requested()) return false;
+	  std::this_thread::yield();
+	}
+	return true;
+      }
+
+      /**
+       * This must be called from the consumer thread only. It returns
+       * false if the queue is empty.
+       */
+      bool try_pop(T& value) {
+	cell& c = cells[pop_position & mask];
+	if(c.sequence.load(std::memory_order_acquire) != pop_position + 1)
+	  return false;
+	value = std::move(c.value);
+	c.sequence.store(pop_position + mask + 1, std::memory_order_release);
+	++pop_position;
+	return true;
+      }
+
+      /**
+       * This must be called from the consumer thread only. It pops at
+       * most max_size values, that are written in out, and returns the
+       * number of popped values.
+       */
+      template<std::output_iterator<T> OUTPUT_ITERATOR>
+      std::size_t pop(OUTPUT_ITERATOR out, std::size_t max_size) {
+	std::size_t nb = 0;
+	for(; nb < max_size; ++nb) {
+	  cell& c = cells[pop_position & mask];
+	  if(c.sequence.load(std::memory_order_acquire) != pop_position + 1)
+	    break;
+	  *(out++) = std::move(c.value);
+	  c.sequence.store(pop_position + mask + 1, std::memory_order_release);
+	  ++pop_position;
+	}
+	return nb;
+      }
+    };
+
+    // #############
+    // #           #
+    // # Versioned #
+    // #           #
+    // #############
+
+    /**
+     * This holds a value (e.g. the parameters of a controller) that a
+     * single writer thread (e.g. a learner) updates, while many reader
+     * threads (e.g. actors) use it. This is a read-copy-update
+     * scheme: the writer publishes a new copy of the value, and each
+     * read gets a consistent snapshot by a single atomic load of the
+     * current copy, without any lock.
+     *
+     * Old copies are freed by epoch-based reclamation: readers
+     * announce the epoch they have started their read in, and a copy
+     * that has been replaced at some epoch is freed as soon as no
+     * reader can still be reading from an earlier epoch.
+     */
+    template<typename T>
+    class versioned {
+    private:
+
+      struct node {
+	T value;
+	std::size_t version;
+	std::size_t retire_epoch = 0;
+	node(const T& value, std::size_t version) : value(value), version(version) {}
+	node(T&& value, std::size_t version) : value(std::move(value)), version(version) {}
+      };
+
+      // An epoch of 0 means that the reader is not reading.
+      struct alignas(cache_line_size) slot {
+	std::atomic<std::size_t> epoch {0};
+      };
+
+      std::atomic<node*> current;
+      alignas(cache_line_size) std::atomic<std::size_t> global_epoch {1};
+      std::size_t nb_slots;
+      std::unique_ptr<slot[]> slots;
+      std::atomic<std::size_t> nb_readers {0};
+      std::vector<node*> retired; // Only the writer thread handles it.
+      std::size_t last_version = 0; // Only the writer thread handles it.
+
+      void retire(node* old) {
+	old->retire_epoch = global_epoch.fetch_add(1) + 1;
+	retired.push_back(old);
+	reclaim();
+      }
+      
+    public:
+
+      versioned()                            = delete;
+      versioned(const versioned&)            = delete;
+      versioned& operator=(const versioned&) = delete;
+
+      /**
+       * @param max_readers The maximal number of readers that can be made.
+       */
+      versioned(const T& init, std::size_t max_readers)
+	: current(new node(init, 0)), nb_slots(max_readers), slots(new slot[max_readers]) {}
+
+      ~versioned() {
+	delete current.load();
+	for(auto n : retired) delete n;
+      }
+
+      /**
+       * This is a consistent view of the value. The copy it refers to
+       * cannot be freed as long as the snapshot exists.
+       */
+      class snapshot {
+	const node* n = nullptr;
+	slot* s = nullptr;
+	friend class versioned;
+	snapshot(const node* n, slot* s) : n(n), s(s) {}
+      public:
+	snapshot(const snapshot&)            = delete;
+	snapshot& operator=(const snapshot&) = delete;
+	snapshot(snapshot&& other) : n(other.n), s(std::exchange(other.s, nullptr)) {}
+	~snapshot() {if(s) s->epoch.store(0, std::memory_order_release);}
+	
+	const T& operator*()  const {return n->value;}
+	const T* operator->() const {return &(n->value);}
+	std::size_t version() const {return n->version;}
+      };
+
+      /**
+       * A reader must be used by a single thread, and it can hold
+       * only one snapshot at a time. It owns its epoch slot, so it can
+       * be moved (e.g. to the thread that uses it) but not copied:
+       * code that needs it at several places refers to it. If the
+       * value is a function (e.g. a controller), the reader can be
+       * called as the function itself, it then reads the current
+       * value at each call. A default-constructed or moved-from
+       * reader is not valid, reading from it throws a
+       * std::logic_error.
+       */
+      class reader {
+	versioned* holder = nullptr;
+	slot* s = nullptr;
+	friend class versioned;
+	reader(versioned* holder, slot* s) : holder(holder), s(s) {}
+      public:
+	reader()                         = default;
+	reader(const reader&)            = delete;
+	reader& operator=(const reader&) = delete;
+	reader(reader&& other) : holder(std::exchange(other.holder, nullptr)), s(std::exchange(other.s, nullptr)) {}
+	reader& operator=(reader&& other) {
+	  holder = std::exchange(other.holder, nullptr);
+	  s      = std::exchange(other.s, nullptr);
+	  return *this;
+	}
+	
+	bool valid() const {return s != nullptr;}
+
+	snapshot read() const {
+	  if(!valid())
+	    throw std::logic_error("gdyn::parallel::versioned::reader::read : the reader is not valid");
+	  s->epoch.store(holder->global_epoch.load());
+	  return snapshot(holder->current.load(), s);
+	}
+
+	template<typename... ARGS>
+	requires std::invocable<const T&, ARGS...>
+	auto operator()(ARGS&&... args) const {
+	  auto snap = read();
+	  return (*snap)(std::forward<ARGS>(args)...);
+	}
+      };
+
+      /**
+       * This can be called from any thread. It throws a
+       * std::length_error if max_readers readers have already been
+       * made.
+       */
+      reader make_reader() {
+	auto idx = nb_readers.fetch_add(1);
+	if(idx >= nb_slots)
+	  throw std::length_error("gdyn::parallel::versioned::make_reader : too many readers");
+	return reader(this, &(slots[idx]));
+      }
+
+      /**
+       * This must be called by the writer thread only. It publishes a
+       * new version of the value.
+       */
+      void publish(const T& value) {
+	retire(current.exchange(new node(value, ++last_version)));
+      }
+
+      void publish(T&& value) {
+	retire(current.exchange(new node(std::move(value), ++last_version)));
+      }
+
+      /**
+       * This must be called by the writer thread only. It is the
+       * version of the last published value (0 for the initial
+       * one). Readers get the version of their snapshot instead (see
+       * snapshot::version).
+       */
+      std::size_t version() const {return last_version;}
+
+      /**
+       * This must be called by the writer thread only. It frees the
+       * old copies that are not read anymore, and returns the number
+       * of copies that are still waiting for being freed. This is
+       * done at each publication.
+       */
+      std::size_t reclaim() {
+	std::size_t min_epoch = global_epoch.load();
+	std::size_t nb = std::min(nb_readers.load(), nb_slots);
+	for(std::size_t i = 0; i < nb; ++i)
+	  if(auto e = slots[i].epoch.load(); e != 0 && e < min_epoch)
+	    min_epoch = e;
+	auto keep = std::partition(retired.begin(), retired.end(),
+				   [min_epoch](const node* n) {return n->retire_epoch > min_epoch;});
+	for(auto it = keep; it != retired.end(); ++it) delete *it;
+	retired.erase(keep, retired.end());
+	return retired.size();
+      }
+    };
+
+    // ##########
+    // #        #
+    // # Actors #
+    // #        #
+    // ##########
+
+    /**
+     * This pushes the elements of a range (e.g. transitions) into the
+     * queue, until the range ends or a stop is requested. This is the
+     * body of an actor thread.
+     */
+    template<std::ranges::input_range R, typename T>
+    void feed(mpsc_queue<T>& queue, R&& range, std::stop_token stop) {
+      for(auto&& value : range)
+	if(stop.stop_requested() || !queue.push(value, stop))
+	  return;
+    }
+  }
+}
@@ -0,0 +1,242 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynParallel.hpp>
+#include <gdynRandom.hpp>
+
+// A particle filter estimates the hidden state of a partially
+// observed system from its observations. The hypotheses (the
+// particles) are moved with the command sent to the system, weighted
+// by the likelihood of the observation, and resampled when the
+// weights become too uneven.
+//
+// The particles are provided by a concepts::particles type, that
+// stores them as it likes (typically a structure of arrays, so that
+// the transition loops over the particles can be vectorized). The
+// particles are processed by blocks, in parallel. The random stream
+// of a block only depends on the seed, the block and the step, so the
+// filter gives the same results whatever the number of threads.
+
+namespace gdyn {
+  namespace system {
+
+    /**
+     * This wraps a system, whose observation becomes the estimation of
+     * its state by a particle filter. The wrapped system must outlive
+     * the filter.
+     */
+    template<concepts::system BASE_SYSTEM,
+	     concepts::particles<typename BASE_SYSTEM::observation_type, typename BASE_SYSTEM::command_type> PARTICLES>
+    class particle_filter {
+    public:
+
+      using observation_type = typename PARTICLES::estimate_type;
+      using command_type     = typename BASE_SYSTEM::command_type;
+      using state_type       = typename BASE_SYSTEM::state_type;
+      using report_type      = typename BASE_SYSTEM::report_type;
+
+      static constexpr std::size_t block_size = 1024;
+
+    private:
+
+      BASE_SYSTEM& base_system;
+      PARTICLES set;
+      std::uint64_t seed;
+      std::uint32_t step = 0;
+      double resampling_threshold;
+      unsigned int nb_threads;
+      std::vector<double> log_weights;   // Unnormalized.
+      std::vector<double> w;             // Normalized.
+      std::vector<double> block_values;  // One per block.
+      std::vector<std::size_t> ancestors;
+      observation_type current_estimate;
+      bool resampled = false;
+
+      std::size_t nb_blocks() const {return (set.size() + block_size - 1) / block_size;}
+
+      // This calls f(b, first, last, gen) for each block b.
+      template<typename F>
+      void for_each_block(const F& f) {
+	std::size_t n = set.size();
+	parallel::for_each_index(nb_blocks(),
+				 [this, &f, n](std::size_t b) {
+				   random::stream gen(seed, b, step);
+				   f(b, b * block_size, std::min(n, (b + 1) * block_size), gen);
+				 },
+				 nb_threads);
+      }
+
+      // The particles get the terminal flag of the system along with
+      // the observation, if they handle it.
+      void reset_particles(const typename BASE_SYSTEM::observation_type& observation, bool terminal,
+			   std::size_t first, std::size_t last, random::stream& gen) {
+	if constexpr(requires {set.reset(observation, terminal, first, last, gen);}) set.reset(observation, terminal, first, last, gen);
+	else                                                                         set.reset(observation, first, last, gen);
+      }
+
+      void log_likelihood(const typename BASE_SYSTEM::observation_type& observation, bool terminal,
+			  std::size_t first, std::size_t last, double* out) const {
+	if constexpr(requires {set.log_likelihood(observation, terminal, first, last, out);}) set.log_likelihood(observation, terminal, first, last, out);
+	else                                                                                  set.log_likelihood(observation, first, last, out);
+      }
+
+      void reset() {
+	auto observation = *base_system;
+	bool terminal = !base_system;
+	for_each_block([this, &observation, terminal](std::size_t, std::size_t first, std::size_t last, random::stream& gen) {
+	  reset_particles(observation, terminal, first, last, gen);
+	});
+	++step;
+	std::fill(log_weights.begin(), log_weights.end(), 0.);
+	std::fill(w.begin(), w.end(), 1. / set.size());
+	current_estimate = set.estimate(w);
+      }
+
+      // This draws the ancestors of the particles, with a single
+      // random number (systematic resampling).
+      void resample() {
+	random::stream gen(seed, std::numeric_limits<std::uint64_t>::max(), step);
+	std::size_t n = set.size();
+	double u = std::uniform_real_distribution<double>(0, 1)(gen);
+	double cumulated = w[0];
+	std::size_t j = 0;
+	for(std::size_t i = 0; i < n; ++i) {
+	  double position = (u + i) / n;
+	  while(position > cumulated && j + 1 < n) cumulated += w[++j];
+	  ancestors[i] = j;
+	}
+	set.resample(ancestors);
+	std::fill(log_weights.begin(), log_weights.end(), 0.);
+	std::fill(w.begin(), w.end(), 1. / n);
+      }
+
+    public:
+
+      particle_filter()                                  = delete;
+      particle_filter(const particle_filter&)            = default;
+      particle_filter(particle_filter&&)                 = default;
+
+      /**
+       * @param resampling_threshold The particles are resampled when the effective sample size is below resampling_threshold * particles.size().
+       */
+      particle_filter(BASE_SYSTEM& base_system, const PARTICLES& particles, std::uint64_t seed,
+		      double resampling_threshold = .5, unsigned int nb_threads = std::thread::hardware_concurrency())
+	: base_system(base_system), set(particles), seed(seed), resampling_threshold(resampling_threshold), nb_threads(nb_threads),
+	  log_weights(set.size()), w(set.size()), block_values(nb_blocks()), ancestors(set.size()), current_estimate() {
+	if(set.size() == 0)
+	  throw std::invalid_argument("gdyn::system::particle_filter : there must be particles");
+	reset();
+      }
+
+      /**
+       * This sets the state of the wrapped system. The particles are
+       * drawn from the first observation, since the state is hidden.
+       */
+      particle_filter& operator=(const state_type& init_state) {
+	base_system = init_state;
+	reset();
+	return *this;
+      }
+
+      observation_type operator*() const {return current_estimate;}
+      operator bool() const              {return base_system;}
+
+      report_type operator()(command_type command) {
+	auto report = base_system(command);
+	auto observation = *base_system;
+	bool terminal = !base_system;
+
+	// The particles are moved and weighted, the maximal log weight
+	// of each block is kept for normalizing.
+	for_each_block([this, &command, &observation, terminal](std::size_t b, std::size_t first, std::size_t last, random::stream& gen) {
+	  set.move(command, first, last, gen);
+	  double* lw = log_weights.data();
+	  double* ll = w.data(); // w is used as a buffer for the likelihoods.
+	  log_likelihood(observation, terminal, first, last, ll);
+	  double m = -std::numeric_limits<double>::infinity();
+	  for(std::size_t i = first; i < last; ++i) m = std::max(m, lw[i] += ll[i]);
+	  block_values[b] = m;
+	});
+	double max = *std::max_element(block_values.begin(), block_values.end());
+	if(max == -std::numeric_limits<double>::infinity()) { // No particle explains the observation.
+	  reset();
+	  return report;
+	}
+
+	for_each_block([this, max](std::size_t b, std::size_t first, std::size_t last, random::stream&) {
+	  double sum = 0;
+	  for(std::size_t i = first; i < last; ++i) sum += (w[i] = std::exp(log_weights[i] - max));
+	  block_values[b] = sum;
+	});
+	double sum = 0;
+	for(auto s : block_values) sum += s;
+	double offset = max + std::log(sum);
+	for_each_block([this, sum, offset](std::size_t b, std::size_t first, std::size_t last, random::stream&) {
+	  double inv = 1 / sum;
+	  double sum2 = 0;
+	  for(std::size_t i = first; i < last; ++i) {
+	    double wi = (w[i] *= inv);
+	    sum2 += wi * wi;
+	    log_weights[i] -= offset;
+	  }
+	  block_values[b] = sum2;
+	});
+	double sum2 = 0;
+	for(auto s : block_values) sum2 += s;
+
+	resampled = 1 / sum2 < resampling_threshold * set.size();
+	if(resampled) resample();
+	++step;
+	current_estimate = set.estimate(w);
+	return report;
+      }
+
+      const PARTICLES&        particles() const {return set;}
+      std::span<const double> weights()   const {return w;}
+
+      /**
+       * This tells whether the particles have been resampled at the last transition.
+       */
+      bool has_resampled() const {return resampled;}
+    };
+
+    /**
+     * This wraps a system so that its observation is the estimation of
+     * its state by a particle filter.
+     */
+    template<concepts::system BASE_SYSTEM, typename PARTICLES>
+    auto make_particle_filter(BASE_SYSTEM& base_system, const PARTICLES& particles, std::uint64_t seed,
+			      double resampling_threshold = .5, unsigned int nb_threads = std::thread::hardware_concurrency()) {
+      return particle_filter<BASE_SYSTEM, PARTICLES>(base_system, particles, seed, resampling_threshold, nb_threads);
+    }
+  }
+}
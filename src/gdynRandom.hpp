@@ -0,0 +1,208 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// This implements the Philox4x32-10 counter-based generator from
+//   J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw, "Parallel
+//   random numbers: as easy as 1, 2, 3", SC'11.
+//
+// A counter-based generator computes the n-th random block directly
+// from n (the counter) and a key (the seed). There is no internal
+// state to share, so any part of a simulation can be regenerated
+// independently, on any thread, in any order.
+
+namespace gdyn {
+  namespace random {
+
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type     = std::array<std::uint32_t, 2>;
+    using block_type   = std::array<std::uint32_t, 4>;
+
+    namespace philox {
+      inline constexpr std::uint32_t M0 = 0xD2511F53;
+      inline constexpr std::uint32_t M1 = 0xCD9E8D57;
+      inline constexpr std::uint32_t W0 = 0x9E3779B9;
+      inline constexpr std::uint32_t W1 = 0xBB67AE85;
+      inline constexpr unsigned int nb_rounds = 10;
+
+      /**
+       * This computes the random block associated to a counter for some key.
+       */
+      constexpr block_type block(counter_type c, key_type k) {
+	for(unsigned int r = 0; r < nb_rounds; ++r) {
+	  std::uint64_t p0 = std::uint64_t(M0) * c[0];
+	  std::uint64_t p1 = std::uint64_t(M1) * c[2];
+	  c = {std::uint32_t(p1 >> 32) ^ c[1] ^ k[0], std::uint32_t(p1),
+	       std::uint32_t(p0 >> 32) ^ c[3] ^ k[1], std::uint32_t(p0)};
+	  k[0] += W0;
+	  k[1] += W1;
+	}
+	return c;
+      }
+
+      /**
+       * This fills out with the blocks of successive counters, the
+       * first word of the counter being incremented. Blocks are
+       * computed by packs of independent lanes, so that the compiler
+       * can vectorize the rounds. This is the same as calling block
+       * for each counter.
+       */
+      inline void fill(std::span<std::uint32_t> out, counter_type first, key_type k) {
+	constexpr std::size_t lanes = 8;
+	std::size_t nb_blocks = out.size() / 4;
+	std::size_t b = 0;
+	for(; b + lanes <= nb_blocks; b += lanes) {
+	  std::uint32_t c0[lanes], c1[lanes], c2[lanes], c3[lanes];
+	  for(std::size_t l = 0; l < lanes; ++l) {
+	    c0[l] = first[0] + std::uint32_t(b + l);
+	    c1[l] = first[1];
+	    c2[l] = first[2];
+	    c3[l] = first[3];
+	  }
+	  std::uint32_t k0 = k[0], k1 = k[1];
+	  for(unsigned int r = 0; r < nb_rounds; ++r) {
+	    for(std::size_t l = 0; l < lanes; ++l) {
+	      std::uint64_t p0 = std::uint64_t(M0) * c0[l];
+	      std::uint64_t p1 = std::uint64_t(M1) * c2[l];
+	      std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+	      std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+	      c1[l] = std::uint32_t(p1);
+	      c3[l] = std::uint32_t(p0);
+	      c0[l] = n0;
+	      c2[l] = n2;
+	    }
+	    k0 += W0;
+	    k1 += W1;
+	  }
+	  for(std::size_t l = 0; l < lanes; ++l) {
+	    auto dst = out.data() + 4 * (b + l);
+	    dst[0] = c0[l]; dst[1] = c1[l]; dst[2] = c2[l]; dst[3] = c3[l];
+	  }
+	}
+	for(auto dst = out.data() + 4 * b; b < nb_blocks; ++b, dst += 4) {
+	  counter_type c = first;
+	  c[0] += std::uint32_t(b);
+	  auto blk = block(c, k);
+	  std::copy(blk.begin(), blk.end(), dst);
+	}
+	if(auto rest = out.size() % 4; rest != 0) {
+	  counter_type c = first;
+	  c[0] += std::uint32_t(nb_blocks);
+	  auto blk = block(c, k);
+	  std::copy(blk.begin(), blk.begin() + rest, out.data() + 4 * nb_blocks);
+	}
+      }
+    }
+
+    inline constexpr key_type key(std::uint64_t seed) {
+      return {std::uint32_t(seed), std::uint32_t(seed >> 32)};
+    }
+
+    // The counter is (draw, step, orbit), the orbit taking two words.
+    inline constexpr counter_type counter(std::uint64_t orbit, std::uint32_t step, std::uint32_t draw = 0) {
+      return {draw, step, std::uint32_t(orbit), std::uint32_t(orbit >> 32)};
+    }
+
+    /**
+     * This is a uniform random bit generator (it can be used with the
+     * std distributions), whose values are addressed by (seed, orbit,
+     * step). For a given seed and orbit, the successive values of a
+     * stream are always the same, whatever the thread or the order
+     * the orbits are simulated in. Seeking a step makes the stream
+     * jump to the values of that step, without computing the values
+     * of the previous ones.
+     */
+    class stream {
+    private:
+      key_type k;
+      counter_type c;
+      block_type values;
+      unsigned int next; // The rank of the next value to be served in values.
+
+    public:
+
+      using result_type = std::uint32_t;
+      static constexpr result_type min() {return 0;}
+      static constexpr result_type max() {return std::numeric_limits<result_type>::max();}
+
+      stream(std::uint64_t seed, std::uint64_t orbit = 0, std::uint32_t step = 0)
+	: k(random::key(seed)), c(random::counter(orbit, step)), values(), next(4) {}
+
+      stream()                         = delete;
+      stream(const stream&)            = default;
+      stream& operator=(const stream&) = default;
+
+      /**
+       * This makes the stream serve the values of some step of the current orbit.
+       */
+      void seek(std::uint32_t step) {
+	c[0] = 0;
+	c[1] = step;
+	next = 4;
+      }
+
+      /**
+       * This makes the stream serve the values of some orbit, from step 0.
+       */
+      void seek(std::uint64_t orbit, std::uint32_t step) {
+	c = random::counter(orbit, step);
+	next = 4;
+      }
+
+      result_type operator()() {
+	if(next == 4) {
+	  values = philox::block(c, k);
+	  ++(c[0]);
+	  next = 0;
+	}
+	return values[next++];
+      }
+    };
+
+    /**
+     * This converts a 32-bit random value into a double in [0, 1).
+     */
+    inline constexpr double to_unit(std::uint32_t value) {
+      return value * (1.0 / 4294967296.0);
+    }
+
+    /**
+     * This fills out with uniform doubles in [0, 1), computed from
+     * the values of (seed, orbit, step). This is intended for batch
+     * engines, that need many random values per step.
+     */
+    inline void uniform(std::span<double> out, std::uint64_t seed, std::uint64_t orbit, std::uint32_t step) {
+      constexpr std::size_t chunk = 256;
+      std::array<std::uint32_t, chunk> bits;
+      auto k = random::key(seed);
+      for(std::size_t start = 0; start < out.size(); start += chunk) {
+	std::size_t size = std::min(chunk, out.size() - start);
+	philox::fill(std::span<std::uint32_t>(bits.data(), size), random::counter(orbit, step, std::uint32_t(start / 4)), k);
+	for(std::size_t i = 0; i < size; ++i) out[start + i] = to_unit(bits[i]);
+      }
+    }
+  }
+}
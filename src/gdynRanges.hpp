@@ -18,9 +18,14 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <tuple>
+#include <vector>
 
 #include <gdynConcepts.hpp>
 #include <gdynIterators.hpp>
@@ -65,6 +70,44 @@ namespace gdyn {
 	constexpr auto operator|(const CLOSURE& closure) const {return closure(*this);}
       };
 
+
+      // ###################
+      // #                 #
+      // # Random commands #
+      // #                 #
+      // ###################
+
+      /**
+       * This range provides uniformly drawn commands forever. The
+       * commands are computed by blocks, from the counter-based
+       * stream (seed, orbit) (see gdyn::random). This is a faster
+       * alternative to views::pulse([&gen](){return random_command(gen);}).
+       */
+      template<concepts::enumerable COMMAND>
+      class random_commands_view : public std::ranges::view_interface<random_commands_view<COMMAND>> {
+      private:
+	std::uint64_t seed  = 0;
+	std::uint64_t orbit = 0;
+      public:
+
+	random_commands_view()                                       = default;
+	random_commands_view(const random_commands_view&)            = default;
+	random_commands_view& operator=(const random_commands_view&) = default;
+	
+	random_commands_view(std::uint64_t seed, std::uint64_t orbit) : seed(seed), orbit(orbit) {}
+
+	constexpr auto begin() const {return iterators::random_commands<COMMAND>(seed, orbit);}
+	constexpr auto end()   const {return iterators::terminal;} // unreachable.
+      };
+
+      /**
+       * @param orbit This selects a stream, so that different orbits
+       * can be fed with different commands from the same seed.
+       */
+      template<concepts::system SYSTEM>
+      requires concepts::enumerable<typename SYSTEM::command_type>
+      auto random_commands(std::uint64_t seed, std::uint64_t orbit = 0) {return random_commands_view<typename SYSTEM::command_type>(seed, orbit);}
+
     
       // ##############
       // #            #
@@ -142,8 +185,8 @@ namespace gdyn {
       // iterator type iterators::terminal_t as a sentinel.
       constexpr auto begin() const {
 	return iterators::orbit<SYSTEM,
-				std::ranges::iterator_t<R>,
-				std::ranges::sentinel_t<R>>(*system, from.begin(), from.end());
+				std::ranges::iterator_t<const R>,
+				std::ranges::sentinel_t<const R>>(*system, from.begin(), from.end());
       }
 
       constexpr auto end()   const {return iterators::terminal;}
@@ -191,6 +234,102 @@ namespace gdyn {
     }
 
 
+
+
+    // ############
+    // #          #
+    // # Episodes #
+    // #          #
+    // ############
+
+    namespace details {
+      // Views have to be assignable, while lambdas with captures are
+      // not. This box makes a function assignable by rebuilding it.
+      template<typename F>
+      class function_box {
+	std::optional<F> f;
+      public:
+	function_box()                    = default;
+	function_box(const function_box&) = default;
+	function_box(function_box&&)      = default;
+	function_box(const F& f) : f(f) {}
+	function_box& operator=(const function_box& other) {
+	  if(this != &other) {f.reset(); if(other.f) f.emplace(*(other.f));}
+	  return *this;
+	}
+	function_box& operator=(function_box&& other) {
+	  if(this != &other) {f.reset(); if(other.f) f.emplace(std::move(*(other.f)));}
+	  return *this;
+	}
+	const F& operator*() const {return *f;}
+      };
+    }
+
+    /**
+     * This range builds up successive orbits of a dynamical
+     * system. Each time a terminal state is reached, the system is
+     * reset from a state generator, and the next orbit point is the
+     * first one of a new episode. Each orbit point carries the rank
+     * of its episode. At each reset, the command source is advanced
+     * after the system has been reset, so that the first command of
+     * an episode is decided from its first observation (e.g. by
+     * views::controller, even wrapped in other views). The command
+     * that was pending at the terminal state is thus discarded.
+     */
+    template<std::ranges::input_range R,
+	     concepts::system SYSTEM,
+	     std::invocable STATE_GENERATOR>
+    requires std::ranges::view<R> &&
+    concepts::command_iterator<std::ranges::iterator_t<R>, typename SYSTEM::command_type> &&
+    std::convertible_to<std::invoke_result_t<const STATE_GENERATOR&>, typename SYSTEM::state_type>
+    class episodes_view : public std::ranges::view_interface<episodes_view<R, SYSTEM, STATE_GENERATOR>> {
+    private:
+      R from {};
+      SYSTEM* system = nullptr;
+      details::function_box<STATE_GENERATOR> generate;
+
+    public:
+
+      episodes_view() = default;
+      episodes_view(R from, SYSTEM& system, const STATE_GENERATOR& generate) : from(from), system(&system), generate(generate) {}
+
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+
+      // The system is reset before the command source is started,
+      // since the latter may depend on the system observation (see
+      // views::controller).
+      constexpr auto begin() const {
+	*system = (*generate)();
+	return iterators::episodes<SYSTEM,
+				   STATE_GENERATOR,
+				   std::ranges::iterator_t<const R>,
+				   std::ranges::sentinel_t<const R>>(*system, *generate, from.begin(), from.end());
+      }
+
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R, typename SYSTEM, typename STATE_GENERATOR> episodes_view(R&&, SYSTEM&, const STATE_GENERATOR&) -> episodes_view<std::ranges::views::all_t<R>, SYSTEM, STATE_GENERATOR>;
+
+    namespace details {
+      template<typename SYSTEM, typename STATE_GENERATOR>
+      struct episodes_range_adaptor_closure {
+	SYSTEM& system;
+	STATE_GENERATOR generate;
+	constexpr episodes_range_adaptor_closure(SYSTEM& system, const STATE_GENERATOR& generate) : system(system), generate(generate) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return episodes_view(std::forward<R>(from), system, generate);}
+      };
+
+      template <std::ranges::viewable_range R, typename SYSTEM, typename STATE_GENERATOR>
+      constexpr auto operator | (R&& from, episodes_range_adaptor_closure<SYSTEM, STATE_GENERATOR> const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      template<typename SYSTEM, typename STATE_GENERATOR>
+      auto episodes(SYSTEM& system, STATE_GENERATOR generate) {return details::episodes_range_adaptor_closure<SYSTEM, STATE_GENERATOR>(system, generate);}
+    }
+
     
     // ##############
     // #            #
@@ -217,8 +356,8 @@ namespace gdyn {
       constexpr R base() const & {return from;}
       constexpr R base() &&      {return std::move(from);}
       constexpr auto begin() const {
-	return iterators::transition<std::ranges::iterator_t<R>,
-				     std::ranges::sentinel_t<R>>(from.begin(), from.end());
+	return iterators::transition<std::ranges::iterator_t<const R>,
+				     std::ranges::sentinel_t<const R>>(from.begin(), from.end());
       }
       constexpr auto end()   const {return iterators::terminal;}
     };
@@ -243,6 +382,333 @@ namespace gdyn {
       constexpr auto transition = details::transition_range_adaptor()();
     }
     
+
+
+    /**
+     * This gathers orbit points into n-step transitions. The report
+     * of a transition is the discounted sum of the reports of the n
+     * next steps, and its next observation is the one reached n steps
+     * later. At the end of an episode, the last transitions have less
+     * steps. This is computed in a single pass, with the n + 1 last
+     * orbit points kept in a ring buffer. A std::invalid_argument is
+     * thrown if n is null.
+     */
+    template<std::ranges::input_range R>
+    requires std::ranges::view<R> &&
+    concepts::orbit_iterator<std::ranges::iterator_t<R>>
+    class n_step_transition_view : public std::ranges::view_interface<n_step_transition_view<R>> {
+    private:
+      R from {};
+      unsigned int n = 1;
+      double gamma   = 1;
+
+    public:
+
+      n_step_transition_view() = default;
+      n_step_transition_view(R from, unsigned int n, double gamma) : from(from), n(n), gamma(gamma) {
+	if(n == 0)
+	  throw std::invalid_argument("gdyn::ranges::n_step_transition_view : n must be positive");
+      }
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::n_step_transition<std::ranges::iterator_t<const R>,
+					    std::ranges::sentinel_t<const R>>(from.begin(), from.end(), n, gamma);
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R> n_step_transition_view(R&&, unsigned int, double) -> n_step_transition_view<std::ranges::views::all_t<R>>;
+
+    namespace details {
+      struct n_step_transition_range_adaptor_closure {
+	unsigned int n;
+	double gamma;
+	constexpr n_step_transition_range_adaptor_closure(unsigned int n, double gamma) : n(n), gamma(gamma) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return n_step_transition_view(std::forward<R>(from), n, gamma);}
+      };
+      
+      template <std::ranges::viewable_range R>
+      constexpr auto operator | (R&& from, n_step_transition_range_adaptor_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      inline auto n_step_transition(unsigned int n, double gamma) {return details::n_step_transition_range_adaptor_closure(n, gamma);}
+    }
+
+
+
+    /**
+     * This gathers transitions into minibatches of batch_size
+     * transitions (the last one may be smaller). The range values
+     * are gdyn::minibatch, i.e. spans of the transition fields. The
+     * arrays are allocated once and refilled at each batch, so a
+     * batch is invalidated when the next one is read.
+     */
+    template<std::ranges::input_range R>
+    requires std::ranges::view<R>
+    class minibatch_view : public std::ranges::view_interface<minibatch_view<R>> {
+    private:
+      R from {};
+      std::size_t batch_size = 1;
+
+    public:
+
+      minibatch_view() = default;
+      minibatch_view(R from, std::size_t batch_size) : from(from), batch_size(batch_size) {
+	if(batch_size == 0)
+	  throw std::invalid_argument("gdyn::ranges::minibatch_view : batch_size must be positive");
+      }
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::minibatch<std::ranges::iterator_t<const R>,
+				    std::ranges::sentinel_t<const R>>(from.begin(), from.end(), batch_size);
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R> minibatch_view(R&&, std::size_t) -> minibatch_view<std::ranges::views::all_t<R>>;
+
+    namespace details {
+      struct minibatch_range_adaptor_closure {
+	std::size_t batch_size;
+	constexpr minibatch_range_adaptor_closure(std::size_t batch_size) : batch_size(batch_size) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return minibatch_view(std::forward<R>(from), batch_size);}
+      };
+      
+      template <std::ranges::viewable_range R>
+      constexpr auto operator | (R&& from, minibatch_range_adaptor_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      inline auto minibatch(std::size_t batch_size) {return details::minibatch_range_adaptor_closure(batch_size);}
+    }
+    
+    /**
+     * This normalizes the observations of orbit points or transitions
+     * (the observation and the next observation) with a
+     * gdyn::normalizer, that must outlive the range. The normalizer is
+     * updated with each observation on the fly, unless it is frozen:
+     * nothing is pushed by begin(), but each traversal of the range
+     * pushes the observations it goes through, so that traversing it
+     * twice counts them twice. In multi-threaded setups, each thread
+     * feeds its own normalizer, they are merged afterwards, or a
+     * frozen one is shared.
+     */
+    template<std::ranges::input_range R, typename NORMALIZER>
+    requires std::ranges::view<R>
+    class normalize_view : public std::ranges::view_interface<normalize_view<R, NORMALIZER>> {
+    private:
+      R from {};
+      NORMALIZER* normalizer = nullptr;
+
+    public:
+
+      normalize_view() = default;
+      normalize_view(R from, NORMALIZER& normalizer) : from(from), normalizer(&normalizer) {}
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::normalize<std::ranges::iterator_t<const R>,
+				    std::ranges::sentinel_t<const R>,
+				    NORMALIZER>(from.begin(), from.end(), *normalizer);
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R, typename NORMALIZER> normalize_view(R&&, NORMALIZER&) -> normalize_view<std::ranges::views::all_t<R>, NORMALIZER>;
+
+    namespace details {
+      template<typename NORMALIZER>
+      struct normalize_range_adaptor_closure {
+	NORMALIZER* normalizer;
+	constexpr normalize_range_adaptor_closure(NORMALIZER& normalizer) : normalizer(&normalizer) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return normalize_view(std::forward<R>(from), *normalizer);}
+      };
+      
+      template <std::ranges::viewable_range R, typename NORMALIZER>
+      constexpr auto operator | (R&& from, normalize_range_adaptor_closure<NORMALIZER> const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      template<typename NORMALIZER>
+      auto normalize(NORMALIZER& normalizer) {return details::normalize_range_adaptor_closure<NORMALIZER>(normalizer);}
+    }
+    
+    /**
+     * This yields, for each orbit point, the history of the last k
+     * points of its episode (less at the beginning of an episode),
+     * the oldest first. Histories are spans of a ring buffer that is
+     * mirrored to stay contiguous, so no copy is made per history. A
+     * history is invalidated when the next one is read. See
+     * gdyn::history_hash and gdyn::history_equal for using histories
+     * as keys.
+     */
+    template<std::ranges::input_range R>
+    requires std::ranges::view<R> &&
+    concepts::orbit_iterator<std::ranges::iterator_t<R>>
+    class history_view : public std::ranges::view_interface<history_view<R>> {
+    private:
+      R from {};
+      std::size_t k = 1;
+
+    public:
+
+      history_view() = default;
+      history_view(R from, std::size_t k) : from(from), k(k) {
+	if(k == 0)
+	  throw std::invalid_argument("gdyn::ranges::history_view : k must be positive");
+      }
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::history<std::ranges::iterator_t<const R>,
+				  std::ranges::sentinel_t<const R>>(from.begin(), from.end(), k);
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R> history_view(R&&, std::size_t) -> history_view<std::ranges::views::all_t<R>>;
+
+    namespace details {
+      struct history_range_adaptor_closure {
+	std::size_t k;
+	constexpr history_range_adaptor_closure(std::size_t k) : k(k) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return history_view(std::forward<R>(from), k);}
+      };
+      
+      template <std::ranges::viewable_range R>
+      constexpr auto operator | (R&& from, history_range_adaptor_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      inline auto history(std::size_t k) {return details::history_range_adaptor_closure(k);}
+    }
+    
+    // ###############
+    // #             #
+    // # Batch orbit #
+    // #             #
+    // ###############
+
+    /**
+     * This range builds up the orbits of many systems at once. A tick
+     * calls the batch controller once, for all the systems that are
+     * not in a terminal state, and then performs the transition of
+     * each of them. The range values are spans of the current orbit
+     * points (one per system whose orbit is not over). Each orbit
+     * point tells the lane, i.e. the rank of its system. The batch
+     * controller must return a command per observation, a
+     * std::length_error is thrown otherwise.
+     */
+    template<concepts::system SYSTEM,
+	     concepts::batch_controller<typename SYSTEM::observation_type, typename SYSTEM::command_type> CONTROLLER>
+    class batch_orbit_view : public std::ranges::view_interface<batch_orbit_view<SYSTEM, CONTROLLER>> {
+    private:
+      std::span<SYSTEM> systems;
+      CONTROLLER* controller = nullptr;
+
+    public:
+
+      batch_orbit_view() = default;
+      batch_orbit_view(std::span<SYSTEM> systems, CONTROLLER& controller) : systems(systems), controller(&controller) {}
+
+      constexpr auto begin() const {return iterators::batch_orbit<SYSTEM, CONTROLLER>(systems, *controller);}
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+
+    namespace views {
+      template<typename SYSTEM, typename CONTROLLER>
+      auto batch_orbit(std::span<SYSTEM> systems, CONTROLLER& controller) {return batch_orbit_view<SYSTEM, CONTROLLER>(systems, controller);}
+      
+      template<typename SYSTEM, typename CONTROLLER>
+      auto batch_orbit(std::vector<SYSTEM>& systems, CONTROLLER& controller) {return batch_orbit_view<SYSTEM, CONTROLLER>(systems, controller);}
+    }
+
+    /**
+     * This gathers the points of a batch orbit into transitions. The
+     * range values are spans of the transitions performed at each
+     * tick.
+     */
+    template<std::ranges::input_range R>
+    requires std::ranges::view<R>
+    class batch_transition_view : public std::ranges::view_interface<batch_transition_view<R>> {
+    private:
+      R from {};
+
+    public:
+
+      batch_transition_view() = default;
+      batch_transition_view(R from) : from(from) {}
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::batch_transition<std::ranges::iterator_t<const R>,
+					   std::ranges::sentinel_t<const R>>(from.begin(), from.end());
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+    
+    template<typename R> batch_transition_view(R&&) -> batch_transition_view<std::ranges::views::all_t<R>>;
+
+    namespace details {
+      struct batch_transition_range_adaptor_closure {
+	constexpr batch_transition_range_adaptor_closure() {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return batch_transition_view(std::forward<R>(from));}
+      };
+      
+      template <std::ranges::viewable_range R>
+      constexpr auto operator | (R&& from, batch_transition_range_adaptor_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+    
+    namespace views {
+      constexpr auto batch_transition = details::batch_transition_range_adaptor_closure();
+    }
+
+    /**
+     * This extracts the orbit of a single lane from a batch orbit. The
+     * values are the orbit points of that lane, so that the range can
+     * be used as any other orbit (e.g. with views::transition). All
+     * the systems of the batch are still driven, as the batch orbit
+     * is iterated.
+     */
+    template<std::ranges::input_range R>
+    requires std::ranges::view<R>
+    class lane_view : public std::ranges::view_interface<lane_view<R>> {
+    private:
+      R from {};
+      std::size_t rank = 0;
+
+    public:
+
+      lane_view() = default;
+      lane_view(R from, std::size_t rank) : from(from), rank(rank) {}
+      constexpr R base() const & {return from;}
+      constexpr R base() &&      {return std::move(from);}
+      constexpr auto begin() const {
+	return iterators::lane<std::ranges::iterator_t<const R>,
+			       std::ranges::sentinel_t<const R>>(from.begin(), from.end(), rank);
+      }
+      constexpr auto end()   const {return iterators::terminal;}
+    };
+
+    template<typename R> lane_view(R&&, std::size_t) -> lane_view<std::ranges::views::all_t<R>>;
+
+    namespace details {
+      struct lane_range_adaptor_closure {
+	std::size_t rank;
+	constexpr lane_range_adaptor_closure(std::size_t rank) : rank(rank) {}
+	template <std::ranges::viewable_range R> constexpr auto operator()(R&& from) const {return lane_view(std::forward<R>(from), rank);}
+      };
+
+      template <std::ranges::viewable_range R>
+      constexpr auto operator | (R&& from, lane_range_adaptor_closure const& closure) {return closure(std::forward<R>(from));}
+    }
+
+    namespace views {
+      inline auto lane(std::size_t rank) {return details::lane_range_adaptor_closure(rank);}
+    }
   }
 
   
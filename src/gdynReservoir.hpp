@@ -0,0 +1,260 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gdynRandom.hpp>
+
+// A reservoir keeps a random sample of at most capacity values from
+// a stream of unknown (possibly huge) length, with a fixed memory.
+//
+// The uniform reservoir implements Algorithm L from
+//   K.-H. Li, "Reservoir-sampling algorithms of time complexity
+//   O(n(1 + log(N/n)))", ACM TOMS 20(4), 1994.
+// Rather than drawing a random number per value, it draws the
+// number of values to skip before the next one enters the
+// reservoir.
+//
+// The weighted reservoir implements A-ExpJ from
+//   P. S. Efraimidis and P. G. Spirakis, "Weighted random sampling
+//   with a reservoir", Information Processing Letters 97(5), 2006.
+// It skips values as well, the skip being an amount of weight.
+//
+// Random numbers come from a gdyn::random::stream, so a sample only
+// depends on the seed and on the stream content.
+
+namespace gdyn {
+  namespace reservoir {
+
+    namespace details {
+      // This is a uniform double in (0, 1), with 53 random bits.
+      inline double open_unit(random::stream& gen) {
+	std::uint64_t bits = (std::uint64_t(gen()) << 21) ^ gen();
+	return ((bits & ((std::uint64_t(1) << 53) - 1)) + .5) * (1.0 / 9007199254740992.0);
+      }
+    }
+
+    /**
+     * This is a uniform sample of the pushed values.
+     */
+    template<typename T>
+    class uniform {
+    private:
+      std::vector<T> values;
+      std::size_t capacity;
+      random::stream gen;
+      std::uint64_t nb_seen = 0;
+      std::uint64_t next    = 0; // The rank of the next value entering a full reservoir.
+      double w = 0;
+
+      double log_unit() {return std::log(details::open_unit(gen));}
+
+      void skip() {
+	next += static_cast<std::uint64_t>(std::floor(log_unit() / std::log1p(-w))) + 1;
+      }
+
+    public:
+
+      using value_type = T;
+
+      uniform()                          = delete;
+      uniform(const uniform&)            = default;
+      uniform& operator=(const uniform&) = default;
+      uniform(uniform&&)                 = default;
+      uniform& operator=(uniform&&)      = default;
+
+      uniform(std::size_t capacity, std::uint64_t seed) : capacity(capacity), gen(seed) {
+	if(capacity == 0)
+	  throw std::invalid_argument("gdyn::reservoir::uniform : capacity must be positive");
+	values.reserve(capacity);
+      }
+
+      void push(const T& value) {
+	if(values.size() < capacity) {
+	  values.push_back(value);
+	  if(values.size() == capacity) {
+	    next = nb_seen;
+	    w = std::exp(log_unit() / capacity);
+	    skip();
+	  }
+	}
+	else if(nb_seen == next) {
+	  values[std::uniform_int_distribution<std::size_t>(0, capacity - 1)(gen)] = value;
+	  w *= std::exp(log_unit() / capacity);
+	  skip();
+	}
+	++nb_seen;
+      }
+
+      /**
+       * The number of values pushed so far.
+       */
+      std::uint64_t seen() const {return nb_seen;}
+
+      std::span<const T> samples() const {return values;}
+      std::size_t        size()    const {return values.size();}
+    };
+
+
+    /**
+     * This is a sample of the pushed values, where the probability of
+     * a value to be in the sample is proportional to its weight.
+     * Values whose weight is not positive are never sampled.
+     */
+    template<typename T>
+    class weighted {
+    private:
+      // The reservoir is a min-heap on the keys u^(1/weight), which
+      // are stored as logarithms.
+      struct item {
+	double log_key;
+	T value;
+	bool operator<(const item& other) const {return log_key > other.log_key;}
+      };
+
+      std::vector<item> items;
+      std::size_t capacity;
+      random::stream gen;
+      std::uint64_t nb_seen = 0;
+      double x = 0; // The weight to skip before the next value enters the reservoir.
+
+      double log_unit() {return std::log(details::open_unit(gen));}
+
+      void jump() {x = log_unit() / items.front().log_key;}
+
+    public:
+
+      using value_type = T;
+
+      weighted()                           = delete;
+      weighted(const weighted&)            = default;
+      weighted& operator=(const weighted&) = default;
+      weighted(weighted&&)                 = default;
+      weighted& operator=(weighted&&)      = default;
+
+      weighted(std::size_t capacity, std::uint64_t seed) : capacity(capacity), gen(seed) {
+	if(capacity == 0)
+	  throw std::invalid_argument("gdyn::reservoir::weighted : capacity must be positive");
+	items.reserve(capacity);
+      }
+
+      void push(const T& value, double weight) {
+	++nb_seen;
+	if(!(weight > 0)) return;
+	if(items.size() < capacity) {
+	  items.push_back({log_unit() / weight, value});
+	  std::push_heap(items.begin(), items.end());
+	  if(items.size() == capacity) jump();
+	  return;
+	}
+	x -= weight;
+	if(x > 0) return;
+	// The key of the value is drawn in (t, 1), t being the key
+	// threshold for that weight.
+	double t = std::exp(weight * items.front().log_key);
+	std::pop_heap(items.begin(), items.end());
+	items.back() = {std::log(t + (1 - t) * details::open_unit(gen)) / weight, value};
+	std::push_heap(items.begin(), items.end());
+	jump();
+      }
+
+      /**
+       * The number of values pushed so far.
+       */
+      std::uint64_t seen() const {return nb_seen;}
+
+      std::size_t size() const {return items.size();}
+
+      /**
+       * This is a range of the sampled values.
+       */
+      auto samples() const {return items | std::views::transform(&item::value);}
+    };
+  }
+
+  namespace ranges {
+    namespace details {
+      struct uniform_reservoir_closure {
+	std::size_t capacity;
+	std::uint64_t seed;
+	template <std::ranges::input_range R> auto operator()(R&& from) const {
+	  gdyn::reservoir::uniform<std::ranges::range_value_t<R>> res(capacity, seed);
+	  for(const auto& value : std::forward<R>(from)) res.push(value);
+	  return res;
+	}
+      };
+
+      template <std::ranges::input_range R>
+      auto operator | (R&& from, uniform_reservoir_closure const& closure) {return closure(std::forward<R>(from));}
+
+      template<typename WEIGHT>
+      struct weighted_reservoir_closure {
+	std::size_t capacity;
+	std::uint64_t seed;
+	WEIGHT weight;
+	template <std::ranges::input_range R> auto operator()(R&& from) const {
+	  gdyn::reservoir::weighted<std::ranges::range_value_t<R>> res(capacity, seed);
+	  for(const auto& value : std::forward<R>(from)) res.push(value, weight(value));
+	  return res;
+	}
+      };
+
+      template <std::ranges::input_range R, typename WEIGHT>
+      auto operator | (R&& from, weighted_reservoir_closure<WEIGHT> const& closure) {return closure(std::forward<R>(from));}
+
+      struct report_magnitude {
+	template<typename TRANSITION>
+	double operator()(const TRANSITION& t) const {return std::fabs(static_cast<double>(t.report));}
+      };
+    }
+
+    namespace views {
+      /**
+       * This is a sink: range | reservoir(capacity, seed) consumes the
+       * range (which must end), and returns a uniform reservoir
+       * sample of its values.
+       */
+      inline auto reservoir(std::size_t capacity, std::uint64_t seed) {
+	return details::uniform_reservoir_closure{capacity, seed};
+      }
+
+      /**
+       * This is a sink: range | weighted_reservoir(capacity, seed,
+       * weight) consumes the range (which must end), and returns a
+       * weighted reservoir sample of its values, weight(value) being
+       * the weight of a value. By default, values are transitions
+       * weighted by the magnitude of their report.
+       */
+      template<typename WEIGHT = details::report_magnitude>
+      auto weighted_reservoir(std::size_t capacity, std::uint64_t seed, const WEIGHT& weight = WEIGHT()) {
+	return details::weighted_reservoir_closure<WEIGHT>{capacity, seed, weight};
+      }
+    }
+  }
+}
@@ -0,0 +1,215 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gdynParallel.hpp>
+#include <gdynStore.hpp>
+
+// These compute, for each transition of a store::episodes, the
+// discounted return, the TD(lambda) return or the generalized
+// advantage estimate (GAE). Reports are used as rewards.
+//
+// All of them are reverse scans a[t] = x[t] + c * a[t + 1] within
+// each episode. Episodes are split into chunks that are scanned in
+// parallel, the carry from the next chunk being added afterwards as
+// c^k * carry, which is vectorizable. Short episodes are thus
+// handled in parallel, as well as the pieces of long ones.
+//
+// The values, when required, are the estimated values of each
+// observation of the store (i.e. they are indexed as
+// store.observations()). They are used for bootstrapping at the end
+// of truncated episodes, i.e. the ones for which
+// store.terminated(e) is false. Beware that an episode is stored as
+// truncated only if its last point still has a next command: orbits
+// have to be truncated by taking orbit points (orbit | take(n + 1)),
+// since an orbit fed with n commands (take(n) | orbit) ends with a
+// point without next command, as if it were terminal.
+
+namespace gdyn {
+  namespace returns {
+
+    inline constexpr std::size_t default_chunk_size = 4096;
+
+    namespace details {
+      struct chunk {
+	std::size_t episode;
+	std::size_t first; // The rank of the first transition.
+	std::size_t last;  // The rank after the last transition.
+      };
+
+      /**
+       * This computes out[t] = x[t] + c * out[t + 1] in each episode,
+       * where out[offset(e + 1)] is tail(e). x and out can be the same.
+       */
+      template<typename STORE, typename TAIL>
+      void reverse_scan(const STORE& data, std::span<const double> x, double c, const TAIL& tail,
+			std::span<double> out, std::size_t chunk_size, unsigned int nb_threads) {
+	chunk_size = std::max(chunk_size, std::size_t(1));
+	std::vector<chunk> chunks;
+	std::vector<std::size_t> first_chunk; // The rank in chunks of the first chunk of each episode.
+	bool split = false;
+	for(std::size_t e = 0; e < data.nb_episodes(); ++e) {
+	  first_chunk.push_back(chunks.size());
+	  for(std::size_t first = data.offset(e); first < data.offset(e + 1); first += chunk_size)
+	    chunks.push_back({e, first, std::min(first + chunk_size, data.offset(e + 1))});
+	  split = split || chunks.size() - first_chunk.back() > 1;
+	}
+	first_chunk.push_back(chunks.size());
+
+	// Each chunk is scanned as if the next chunk were null, except
+	// for the last chunk of an episode, that gets the episode tail.
+	parallel::for_each_index(chunks.size(),
+				 [&](std::size_t k) {
+				   const auto& ch = chunks[k];
+				   double acc = (ch.last == data.offset(ch.episode + 1)) ? tail(ch.episode) : 0.;
+				   for(std::size_t t = ch.last; t-- > ch.first;)
+				     out[t] = acc = x[t] + c * acc;
+				 },
+				 nb_threads);
+	if(!split) return; // There is no carry.
+
+	std::vector<double> powers(chunk_size + 1); // powers[i] = c^i
+	powers[0] = 1;
+	for(std::size_t i = 1; i <= chunk_size; ++i) powers[i] = powers[i - 1] * c;
+
+	// The carry of each chunk is the final value of the first
+	// element of the next chunk of the episode.
+	std::vector<double> carries(chunks.size(), 0.);
+	parallel::for_each_index(data.nb_episodes(),
+				 [&](std::size_t e) {
+				   double carry = 0;
+				   for(std::size_t k = first_chunk[e + 1]; k-- > first_chunk[e];) {
+				     carries[k] = carry;
+				     const auto& ch = chunks[k];
+				     carry = out[ch.first] + powers[ch.last - ch.first] * carry;
+				   }
+				 },
+				 nb_threads);
+	parallel::for_each_index(chunks.size(),
+				 [&](std::size_t k) {
+				   double carry = carries[k];
+				   if(carry == 0) return;
+				   const auto& ch = chunks[k];
+				   double* o = out.data();
+				   const double* p = powers.data();
+				   for(std::size_t t = ch.first; t < ch.last; ++t)
+				     o[t] += p[ch.last - t] * carry;
+				 },
+				 nb_threads);
+      }
+
+      template<typename STORE>
+      std::vector<double> rewards(const STORE& data, unsigned int nb_threads) {
+	std::vector<double> res(data.size());
+	auto reports = data.reports();
+	parallel::for_each_index((res.size() + default_chunk_size - 1) / default_chunk_size,
+				 [&](std::size_t b) {
+				   std::size_t last = std::min((b + 1) * default_chunk_size, res.size());
+				   for(std::size_t t = b * default_chunk_size; t < last; ++t) res[t] = static_cast<double>(reports[t]);
+				 },
+				 nb_threads);
+	return res;
+      }
+
+      template<typename STORE>
+      void check(const STORE& data, std::span<double> out, std::span<const double> values) {
+	if(out.size() != data.size())
+	  throw std::invalid_argument("gdyn::returns : out must hold a value per transition");
+	if(values.size() != data.observations().size())
+	  throw std::invalid_argument("gdyn::returns : values must hold a value per observation");
+      }
+    }
+
+    /**
+     * This computes the discounted return of each transition, i.e. the
+     * discounted sum of the rewards until the end of its episode
+     * (truncated episodes are not bootstrapped).
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    void discounted(const store::episodes<OBSERVATION, COMMAND, REPORT>& data, double gamma, std::span<double> out,
+		    unsigned int nb_threads = std::thread::hardware_concurrency(), std::size_t chunk_size = default_chunk_size) {
+      if(out.size() != data.size())
+	throw std::invalid_argument("gdyn::returns : out must hold a value per transition");
+      auto r = details::rewards(data, nb_threads);
+      details::reverse_scan(data, r, gamma, [](std::size_t) {return 0.;}, out, chunk_size, nb_threads);
+    }
+
+    /**
+     * This is the same as above, but the return of truncated episodes
+     * is bootstrapped by the value of their last observation.
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    void discounted(const store::episodes<OBSERVATION, COMMAND, REPORT>& data, std::span<const double> values, double gamma, std::span<double> out,
+		    unsigned int nb_threads = std::thread::hardware_concurrency(), std::size_t chunk_size = default_chunk_size) {
+      details::check(data, out, values);
+      auto r = details::rewards(data, nb_threads);
+      details::reverse_scan(data, r, gamma,
+			    [&data, values](std::size_t e) {return data.terminated(e) ? 0. : values[data.offset(e + 1) + e];},
+			    out, chunk_size, nb_threads);
+    }
+
+    /**
+     * This computes the generalized advantage estimate of each
+     * transition: the discounted sum, with a gamma * lambda factor,
+     * of the temporal differences r + gamma * V(s') - V(s).
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    void gae(const store::episodes<OBSERVATION, COMMAND, REPORT>& data, std::span<const double> values, double gamma, double lambda, std::span<double> out,
+	     unsigned int nb_threads = std::thread::hardware_concurrency(), std::size_t chunk_size = default_chunk_size) {
+      details::check(data, out, values);
+      auto reports = data.reports();
+      std::vector<double> deltas(data.size());
+      parallel::for_each_index(data.nb_episodes(),
+			       [&](std::size_t e) {
+				 std::size_t first = data.offset(e), last = data.offset(e + 1);
+				 const double* v = values.data() + e; // The observation of transition t is t + e.
+				 for(std::size_t t = first; t < last; ++t)
+				   deltas[t] = static_cast<double>(reports[t]) + gamma * v[t + 1] - v[t];
+				 if(last > first && data.terminated(e))
+				   deltas[last - 1] -= gamma * v[last]; // A terminal state has no value.
+			       },
+			       nb_threads);
+      details::reverse_scan(data, deltas, gamma * lambda, [](std::size_t) {return 0.;}, out, chunk_size, nb_threads);
+    }
+
+    /**
+     * This computes the TD(lambda) return of each transition. It is
+     * the generalized advantage estimate plus the value of the
+     * transition observation.
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    void td_lambda(const store::episodes<OBSERVATION, COMMAND, REPORT>& data, std::span<const double> values, double gamma, double lambda, std::span<double> out,
+		   unsigned int nb_threads = std::thread::hardware_concurrency(), std::size_t chunk_size = default_chunk_size) {
+      gae(data, values, gamma, lambda, out, nb_threads, chunk_size);
+      parallel::for_each_index(data.nb_episodes(),
+			       [&](std::size_t e) {
+				 const double* v = values.data() + e;
+				 for(std::size_t t = data.offset(e); t < data.offset(e + 1); ++t) out[t] += v[t];
+			       },
+			       nb_threads);
+    }
+  }
+}
@@ -0,0 +1,438 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynIterators.hpp>
+#include <gdynLog.hpp>
+#include <gdynRanges.hpp>
+#include <gdynTransition.hpp>
+
+namespace gdyn {
+  namespace store {
+
+    /**
+     * This is an orbit point, as provided by the stores.
+     */
+    template<concepts::system SYSTEM>
+    struct point {
+      using observation_type = typename SYSTEM::observation_type;
+      using command_type     = typename SYSTEM::command_type;
+      using report_type      = typename SYSTEM::report_type;
+      observation_type            current_observation;
+      std::optional<command_type> next_command;
+      std::optional<report_type>  previous_report;
+    };
+
+    namespace details {
+      // Enumerable commands are bit-packed (see log::episode).
+      template<concepts::system SYSTEM>
+      struct command_storage {
+	using type = std::vector<typename SYSTEM::command_type>;
+      };
+
+      template<concepts::system SYSTEM>
+      requires concepts::enumerable<typename SYSTEM::command_type>
+      struct command_storage<SYSTEM> {
+	using type = log::episode<SYSTEM>;
+      };
+    }
+
+    // ################
+    // #              #
+    // # Checkpointed #
+    // #              #
+    // ################
+
+    /**
+     * This stores an orbit without storing its points. Only the
+     * commands are kept, as well as the state of the system every
+     * period steps (a checkpoint). The points are recomputed from the
+     * checkpoints when they are needed, with a copy of the system
+     * owned by the store. Enumerable commands are bit-packed.
+     *
+     * Reading the orbit backwards recomputes each segment between
+     * two checkpoints once, so it costs a single extra simulation of
+     * the orbit. With a period of about sqrt(n) for an orbit of n
+     * points (see period_for), the states kept in memory are
+     * O(sqrt(n)).
+     *
+     * The store cannot be read from several threads at once, since
+     * the recomputations share the system copy.
+     *
+     * Recomputing the points is only correct for deterministic
+     * systems, or for systems whose random generator is part of
+     * their state, so that restoring a checkpoint restores it as
+     * well. A system drawing from a generator it does not own (as
+     * cheese_maze::Environment) gives another orbit when it is read
+     * back. When states can be compared, reading the orbit backwards
+     * checks that each recomputed segment leads to the next
+     * checkpoint, and throws a std::runtime_error otherwise.
+     */
+    template<concepts::transparent_system SYSTEM>
+    requires std::copy_constructible<SYSTEM>
+    class checkpointed {
+    public:
+
+      using system_type      = SYSTEM;
+      using state_type       = typename SYSTEM::state_type;
+      using observation_type = typename SYSTEM::observation_type;
+      using command_type     = typename SYSTEM::command_type;
+      using report_type      = typename SYSTEM::report_type;
+      using value_type       = point<SYSTEM>;
+
+    private:
+
+      struct checkpoint {
+	state_type                 state;
+	std::optional<report_type> previous_report;
+      };
+
+      mutable SYSTEM system;
+      std::size_t period;
+      std::vector<checkpoint> checkpoints;  // checkpoints[c] is the state at point c * period.
+      typename details::command_storage<SYSTEM>::type commands; // commands[i] is the command applied at point i.
+      std::size_t nb_points = 0;
+
+      // This sets the system at the checkpoint of point i, and returns the rank of that point.
+      std::size_t restore(std::size_t i, std::optional<report_type>& report) const {
+	const auto& c = checkpoints[i / period];
+	system = c.state;
+	report = c.previous_report;
+	return i - i % period;
+      }
+
+      value_type current(std::size_t i, const std::optional<report_type>& report) const {
+	return {*system, i < commands.size() ? std::optional<command_type>(commands[i]) : std::nullopt, report};
+      }
+
+      // This recomputes the points of a segment.
+      void segment(std::size_t s, std::vector<value_type>& out) const {
+	out.clear();
+	std::optional<report_type> report;
+	std::size_t i    = restore(s * period, report);
+	std::size_t last = std::min(i + period, nb_points);
+	for(; i < last; ++i) {
+	  out.push_back(current(i, report));
+	  if(i + 1 < last) report = system(commands[i]);
+	}
+	if constexpr(std::equality_comparable<state_type>)
+	  if(s + 1 < checkpoints.size()) {
+	    system(commands[last - 1]);
+	    if(!(system.state() == checkpoints[s + 1].state))
+	      throw std::runtime_error("gdyn::store::checkpointed : the recomputed orbit differs from the recorded one (is the system deterministic ?)");
+	  }
+      }
+
+    public:
+
+      checkpointed()                               = delete;
+      checkpointed(const checkpointed&)            = default;
+      checkpointed& operator=(const checkpointed&) = default;
+      checkpointed(checkpointed&&)                 = default;
+      checkpointed& operator=(checkpointed&&)      = default;
+
+      /**
+       * @param system The store uses a copy of it.
+       * @param period The number of steps between two checkpoints.
+       */
+      checkpointed(const SYSTEM& system, std::size_t period) : system(system), period(std::max(period, std::size_t(1))) {}
+
+      /**
+       * This is the period making the memory footprint and the
+       * recomputation cost balanced for orbits of about length points.
+       */
+      static std::size_t period_for(std::size_t length) {
+	return std::max(std::size_t(1), static_cast<std::size_t>(std::ceil(std::sqrt(double(length)))));
+      }
+
+      void clear() {
+	checkpoints.clear();
+	commands.clear();
+	nb_points = 0;
+      }
+
+      /**
+       * This runs the orbit from the initial state, fed by the
+       * commands, and stores it (previous content is cleared). The
+       * orbit ends as views::orbit does.
+       */
+      template<std::ranges::input_range COMMANDS>
+      void record(const state_type& initial_state, COMMANDS&& source) {
+	clear();
+	system = initial_state;
+	for(const auto& p : std::forward<COMMANDS>(source) | views::orbit(system))
+	  push_back(system.state(), p);
+      }
+
+      /**
+       * This appends the next point of an orbit, computed elsewhere
+       * (e.g. when the commands are computed from the observations by
+       * a controller). state is the system state at that point.
+       */
+      template<concepts::orbit_point POINT>
+      void push_back(const state_type& state, const POINT& p) {
+	if(nb_points % period == 0)
+	  checkpoints.push_back({state, p.previous_report});
+	if(p.next_command)
+	  commands.push_back(*(p.next_command));
+	++nb_points;
+      }
+
+      std::size_t size()  const {return nb_points;}
+      bool        empty() const {return nb_points == 0;}
+
+      /**
+       * The number of bytes used by the checkpoints and the commands.
+       */
+      std::size_t memory_size() const {
+	std::size_t res = checkpoints.size() * sizeof(checkpoint);
+	if constexpr(concepts::enumerable<command_type>) return res + commands.memory_size();
+	else                                            return res + commands.size() * sizeof(command_type);
+      }
+
+      /**
+       * This recomputes the i-th point, from the previous checkpoint.
+       */
+      value_type operator[](std::size_t i) const {
+	std::optional<report_type> report;
+	for(std::size_t j = restore(i, report); j < i; ++j)
+	  report = system(commands[j]);
+	return current(i, report);
+      }
+
+      /**
+       * This iterates on the points from the last one to the first one.
+       */
+      class reverse_iterator {
+      public:
+
+	using value_type      = point<SYSTEM>;
+	using difference_type = std::ptrdiff_t;
+
+      private:
+
+	const checkpointed* store = nullptr;
+	std::size_t seg = 0;
+	std::size_t pos = 0; // The number of points of the current segment that remain to be read.
+	std::vector<value_type> buffer;
+
+	friend class checkpointed;
+	reverse_iterator(const checkpointed* store) : store(store) {
+	  if(store->nb_points == 0) return;
+	  seg = (store->nb_points - 1) / store->period;
+	  store->segment(seg, buffer);
+	  pos = buffer.size();
+	}
+
+      public:
+
+	reverse_iterator()                                   = default;
+	reverse_iterator(const reverse_iterator&)            = default;
+	reverse_iterator& operator=(const reverse_iterator&) = default;
+	reverse_iterator(reverse_iterator&&)                 = default;
+	reverse_iterator& operator=(reverse_iterator&&)      = default;
+
+	const value_type& operator*() const {return buffer[pos - 1];}
+
+	reverse_iterator& operator++() {
+	  if(--pos == 0 && seg > 0) {
+	    store->segment(--seg, buffer);
+	    pos = buffer.size();
+	  }
+	  return *this;
+	}
+	void operator++(int) {++(*this);}
+
+	bool operator==(iterators::terminal_t) const {return pos == 0;}
+      };
+
+      /**
+       * This is the range of the points, from the last one to the
+       * first one.
+       */
+      auto reversed() const {return std::ranges::subrange(reverse_iterator(this), iterators::terminal);}
+    };
+
+    // ############
+    // #          #
+    // # Episodes #
+    // #          #
+    // ############
+
+    /**
+     * This stores transitions of successive episodes, column by
+     * column: each observation, command and report is stored once,
+     * contiguously with the ones of the same kind. Transitions are
+     * read as transition_ref values, that refer to the columns.
+     *
+     * The transitions of episode e are the ones ranked in
+     * [offset(e), offset(e + 1)). The observations of episode e are
+     * ranked in [offset(e) + e, offset(e + 1) + e], so that the
+     * observation of transition i of episode e is observations()[i +
+     * e]. The last next_command of each episode, that is missing for
+     * terminal states, is stored apart.
+     */
+    template<typename OBSERVATION, typename COMMAND, typename REPORT>
+    class episodes {
+    public:
+
+      using observation_type = OBSERVATION;
+      using command_type     = COMMAND;
+      using report_type      = REPORT;
+      using value_type       = transition_ref<OBSERVATION, COMMAND, REPORT>;
+
+    private:
+
+      std::vector<observation_type> observation_column;
+      std::vector<command_type>     command_column;
+      std::vector<report_type>      report_column;
+      std::vector<std::size_t>      offsets {0};
+      std::vector<std::optional<command_type>> tails; // The next command of the last point of each episode.
+
+      value_type make(std::size_t i, std::size_t e) const {
+	return {observation_column[i + e], command_column[i], report_column[i], observation_column[i + e + 1],
+		i + 1 < offsets[e + 1] ? std::optional<command_type>(command_column[i + 1]) : tails[e]};
+      }
+
+    public:
+
+      episodes()                           = default;
+      episodes(const episodes&)            = default;
+      episodes& operator=(const episodes&) = default;
+      episodes(episodes&&)                 = default;
+      episodes& operator=(episodes&&)      = default;
+
+      void clear() {
+	observation_column.clear();
+	command_column.clear();
+	report_column.clear();
+	offsets = {0};
+	tails.clear();
+      }
+
+      /**
+       * This appends an orbit point. A point without previous report
+       * starts a new episode, the other ones extend the current
+       * episode, that must not have reached a terminal state. A
+       * std::invalid_argument is thrown otherwise, and the store is
+       * left unchanged.
+       */
+      template<concepts::orbit_point POINT>
+      void push_back(const POINT& p) {
+	if(p.previous_report) {
+	  if(tails.empty())
+	    throw std::invalid_argument("gdyn::store::episodes::push_back : a point with a previous report cannot start the store");
+	  if(!tails.back())
+	    throw std::invalid_argument("gdyn::store::episodes::push_back : a point with a previous report cannot extend a terminated episode");
+	}
+	observation_column.push_back(p.current_observation);
+	if(!p.previous_report) {
+	  offsets.push_back(command_column.size());
+	  tails.push_back(p.next_command);
+	  return;
+	}
+	command_column.push_back(*(tails.back()));
+	report_column.push_back(*(p.previous_report));
+	offsets.back() = command_column.size();
+	tails.back()   = p.next_command;
+      }
+
+      /**
+       * This appends the points of an orbit, the first point starting
+       * a new episode.
+       */
+      template<std::ranges::input_range ORBIT>
+      void push_orbit(ORBIT&& orbit) {
+	for(const auto& p : std::forward<ORBIT>(orbit)) push_back(p);
+      }
+
+      std::size_t size()        const {return command_column.size();} // The number of transitions.
+      bool        empty()       const {return command_column.empty();}
+      std::size_t nb_episodes() const {return tails.size();}
+
+      std::size_t offset(std::size_t e) const {return offsets[e];}
+
+      /**
+       * This tells whether episode e has ended in a terminal state,
+       * rather than being truncated. It is actually whether its last
+       * point has no next command, which is also the case when the
+       * orbit has run out of commands (see gdynReturns.hpp).
+       */
+      bool terminated(std::size_t e) const {return !(tails[e].has_value());}
+
+      std::span<const observation_type> observations() const {return observation_column;}
+      std::span<const command_type>     commands()     const {return command_column;}
+      std::span<const report_type>      reports()      const {return report_column;}
+
+      /**
+       * The number of bytes used by the columns.
+       */
+      std::size_t memory_size() const {
+	return observation_column.size() * sizeof(observation_type)
+	  + command_column.size() * sizeof(command_type)
+	  + report_column.size() * sizeof(report_type)
+	  + offsets.size() * sizeof(std::size_t)
+	  + tails.size() * sizeof(std::optional<command_type>);
+      }
+
+      /**
+       * This is the episode of the i-th transition.
+       */
+      std::size_t episode_of(std::size_t i) const {
+	return std::size_t(std::ranges::upper_bound(offsets, i) - offsets.begin()) - 1;
+      }
+
+      /**
+       * This is the i-th transition. It costs a search for its
+       * episode, prefer episode(e) for iterating.
+       */
+      value_type operator[](std::size_t i) const {return make(i, episode_of(i));}
+
+      /**
+       * The transitions of episode e. The store must outlive the range.
+       */
+      auto episode(std::size_t e) const {
+	return std::views::iota(offsets[e], offsets[e + 1])
+	  | std::views::transform([this, e](std::size_t i) {return make(i, e);});
+      }
+
+      /**
+       * All the transitions, episode after episode.
+       */
+      auto transitions() const {
+	return std::views::iota(std::size_t(0), nb_episodes())
+	  | std::views::transform([this](std::size_t e) {return episode(e);})
+	  | std::views::join;
+      }
+    };
+  }
+}
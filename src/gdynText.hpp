@@ -0,0 +1,250 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+#include <gdynSystem.hpp>
+
+// This writes orbits and transitions as text columns (e.g. for
+// gnuplot). Numbers are formatted by std::to_chars in a large buffer,
+// that is written to the stream when it is full.
+//
+// Values are written as follows:
+//   - numbers as is,
+//   - enumerable values (e.g. commands) as their rank,
+//   - reflected structures (see gdyn::fields) field by field,
+//   - missing optional values as writer::missing,
+//   - gdyn::no_report as nothing.
+
+namespace gdyn {
+  namespace text {
+
+    /**
+     * The number of columns used for writing a value of type T.
+     */
+    template<typename T>
+    constexpr std::size_t width() {
+      if constexpr(std::is_same_v<T, no_report>)   return 0;
+      else if constexpr(concepts::reflected<T>)    return nb_fields<T>;
+      else                                         return 1;
+    }
+
+    class writer {
+    private:
+
+      static constexpr std::size_t max_number_size = 64;
+
+      std::ostream& os;
+      std::vector<char> buffer;
+      std::size_t size = 0;
+      char separator;
+      bool line_start = true;
+
+      char* room(std::size_t n) {
+	if(size + n > buffer.size()) flush();
+	return buffer.data() + size;
+      }
+
+      void separate() {
+	if(!line_start) {
+	  *(room(1)) = separator;
+	  ++size;
+	}
+	line_start = false;
+      }
+
+      void append(std::string_view text) {
+	if(text.size() > buffer.size()) {
+	  flush();
+	  os.write(text.data(), text.size());
+	}
+	else {
+	  std::memcpy(room(text.size()), text.data(), text.size());
+	  size += text.size();
+	}
+      }
+
+    public:
+
+      std::string missing = "NaN"; // gnuplot skips it.
+
+      writer()                         = delete;
+      writer(const writer&)            = delete;
+      writer& operator=(const writer&) = delete;
+
+      /**
+       * @param capacity The size of the buffer.
+       */
+      writer(std::ostream& os, char separator = ' ', std::size_t capacity = std::size_t(1) << 20)
+	: os(os), buffer(std::max(capacity, 4 * max_number_size)), separator(separator) {}
+
+      ~writer() {flush();}
+
+      /**
+       * This writes the buffer content to the stream.
+       */
+      void flush() {
+	os.write(buffer.data(), size);
+	size = 0;
+      }
+
+      writer& put(std::string_view text) {
+	separate();
+	append(text);
+	return *this;
+      }
+
+      writer& put(const char* text) {return put(std::string_view(text));}
+
+      template<typename T>
+      requires std::is_arithmetic_v<T>
+      writer& put(T value) {
+	separate();
+	char* first = room(max_number_size);
+	if constexpr(std::is_same_v<T, bool>) {
+	  *first = value ? '1' : '0';
+	  ++size;
+	}
+	else
+	  size += std::to_chars(first, first + max_number_size, value).ptr - first;
+	return *this;
+      }
+
+      template<concepts::enumerable T>
+      requires (!std::is_arithmetic_v<T> && !concepts::reflected<T>)
+      writer& put(const T& value) {return put(index_of(value));}
+
+      template<concepts::reflected T>
+      writer& put(const T& value) {
+	for_each_field(value, [this](std::string_view, const auto& v) {put(v);});
+	return *this;
+      }
+
+      template<typename T>
+      writer& put(const std::optional<T>& value) {
+	if(value) return put(*value);
+	for(std::size_t i = 0; i < width<T>(); ++i) put(std::string_view(missing));
+	return *this;
+      }
+
+      writer& put(const no_report&) {return *this;}
+
+      /**
+       * This ends the current line.
+       */
+      writer& endl() {
+	*(room(1)) = '\n';
+	++size;
+	line_start = true;
+	return *this;
+      }
+
+      /**
+       * This writes the values, and ends the line.
+       */
+      template<typename... VALUES>
+      writer& row(const VALUES&... values) {
+	(put(values), ...);
+	return endl();
+      }
+
+      /**
+       * This writes the column names for values of type T. Fields
+       * are named prefix.field, other values are named prefix.
+       */
+      template<typename T>
+      writer& names(std::string_view prefix) {
+	if constexpr(std::is_same_v<T, no_report>) {}
+	else if constexpr(concepts::reflected<T>)
+	  std::apply([this, prefix](const auto&... fld) {
+	    ((put(prefix), append("."), append(fld.name)), ...);
+	  }, fields<T>::values);
+	else
+	  put(prefix);
+	return *this;
+      }
+
+      /**
+       * This starts a comment line (e.g. a header), gnuplot ignores it.
+       */
+      writer& comment() {
+	if(!line_start) endl();
+	put(std::string_view("#"));
+	return *this;
+      }
+    };
+
+    /**
+     * This writes the points of an orbit, one per line: the
+     * observation, the next command and the previous report. Missing
+     * values are written as writer::missing.
+     */
+    template<std::ranges::input_range ORBIT>
+    requires concepts::orbit_point<std::ranges::range_value_t<ORBIT>>
+    void orbit(writer& out, ORBIT&& points, bool header = true) {
+      using point = std::ranges::range_value_t<ORBIT>;
+      if(header) {
+	out.comment();
+	out.template names<typename point::observation_type>("observation");
+	out.template names<typename point::command_type>("command");
+	out.template names<typename point::report_type>("report");
+	out.endl();
+      }
+      for(const auto& p : std::forward<ORBIT>(points))
+	out.row(p.current_observation, p.next_command, p.previous_report);
+    }
+
+    /**
+     * This writes transitions, one per line: the observation, the
+     * command, the report and the next observation.
+     */
+    template<std::ranges::input_range TRANSITIONS>
+    void transitions(writer& out, TRANSITIONS&& ts, bool header = true) {
+      using transition = std::remove_cvref_t<std::ranges::range_reference_t<TRANSITIONS>>;
+      using observation_type = std::remove_cvref_t<decltype(std::declval<transition>().observation)>;
+      using command_type     = std::remove_cvref_t<decltype(std::declval<transition>().command)>;
+      using report_type      = std::remove_cvref_t<decltype(std::declval<transition>().report)>;
+      if(header) {
+	out.comment();
+	out.template names<observation_type>("observation");
+	out.template names<command_type>("command");
+	out.template names<report_type>("report");
+	out.template names<observation_type>("next_observation");
+	out.endl();
+      }
+      for(const auto& t : std::forward<TRANSITIONS>(ts))
+	out.row(t.observation, t.command, t.report, t.next_observation);
+    }
+  }
+}
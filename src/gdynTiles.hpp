@@ -0,0 +1,290 @@
+/*
+
+Copyright 2023 Herve FREZZA-BUET, Alain DUTECH
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gdynConcepts.hpp>
+#include <gdynEnumerable.hpp>
+#include <gdynFields.hpp>
+
+// Tile coding maps a continuous value (a reflected structure, see
+// gdyn::fields) to binary features. The value space is covered by
+// several tilings, i.e. grids that are offset from each other. A
+// value activates one tile in each tiling, so its features are the
+// indices of the active tiles.
+//
+// A coder provides:
+//   using input_type = ...;
+//   std::size_t size() const;         // the number of features.
+//   unsigned int nb_tilings() const;  // the number of active features, at most max_tilings.
+//   void operator()(const input_type&, std::span<std::size_t> active) const;
+//
+// A linear function of the features is then the sum of the weights
+// of the active features (see dot).
+
+namespace gdyn {
+  namespace tiles {
+
+    inline constexpr unsigned int max_tilings = 64;
+
+    /**
+     * This is the dot product of the weights and the binary features
+     * whose indices are active.
+     */
+    inline double dot(std::span<const double> weights, std::span<const std::size_t> active) {
+      double res = 0;
+      for(auto idx : active) res += weights[idx];
+      return res;
+    }
+
+    /**
+     * This adds delta to the weights of the active features.
+     */
+    inline void add(std::span<double> weights, std::span<const std::size_t> active, double delta) {
+      for(auto idx : active) weights[idx] += delta;
+    }
+
+    /**
+     * This is a tile coder whose tilings are regular grids over a
+     * box. Each tiling has divisions tiles per field, plus one for
+     * the offset, and tiling t is offset by t * (2i + 1) / nb_tilings
+     * tile along field i (this asymmetric offset avoids the tilings
+     * to be aligned on the diagonal).
+     */
+    template<concepts::reflected T>
+    class grid {
+    public:
+
+      static constexpr std::size_t dim = nb_fields<T>;
+      using input_type = T;
+
+    private:
+
+      std::array<double, dim> min;
+      std::array<double, dim> scale;   // Tiles per unit, along each field.
+      unsigned int divisions;
+      unsigned int tilings;
+      std::size_t  per_tiling;         // (divisions + 1)^dim
+
+    public:
+
+      grid()                       = delete;
+      grid(const grid&)            = default;
+      grid& operator=(const grid&) = default;
+
+      /**
+       * @param min, max The bounds of the box, values out of it are clamped.
+       */
+      grid(const std::array<double, dim>& min, const std::array<double, dim>& max, unsigned int divisions, unsigned int tilings)
+	: min(min), divisions(divisions), tilings(tilings), per_tiling(1) {
+	if(divisions == 0 || tilings == 0 || tilings > max_tilings)
+	  throw std::invalid_argument("gdyn::tiles::grid : divisions and tilings must be in [1, max_tilings]");
+	for(std::size_t i = 0; i < dim; ++i) {
+	  if(!(max[i] > min[i]))
+	    throw std::invalid_argument("gdyn::tiles::grid : empty box");
+	  scale[i] = divisions / (max[i] - min[i]);
+	  per_tiling *= divisions + 1;
+	}
+      }
+
+      /**
+       * The number of features.
+       */
+      std::size_t size() const {return tilings * per_tiling;}
+
+      /**
+       * The number of active features (one per tiling).
+       */
+      unsigned int nb_tilings() const {return tilings;}
+
+      /**
+       * This writes the index of the active tile of each tiling in
+       * active, whose size is nb_tilings().
+       */
+      void operator()(const T& value, std::span<std::size_t> active) const {
+	auto x = as_array(value);
+	std::array<double, dim> coord;
+	for(std::size_t i = 0; i < dim; ++i)
+	  coord[i] = std::clamp((x[i] - min[i]) * scale[i], 0., static_cast<double>(divisions));
+	for(unsigned int t = 0; t < tilings; ++t) {
+	  std::size_t idx = 0;
+	  for(std::size_t i = 0; i < dim; ++i) {
+	    double offset = static_cast<double>((t * (2 * i + 1)) % tilings) / tilings;
+	    idx = idx * (divisions + 1) + static_cast<std::size_t>(coord[i] + offset);
+	  }
+	  active[t] = t * per_tiling + idx;
+	}
+      }
+    };
+
+
+    /**
+     * This is a tile coder whose tiles are hashed into a table of
+     * fixed size. The tilings are unbounded (values out of the
+     * reference box are coded as well), and only the visited tiles
+     * take room in practice. Tiling t is offset as for grid.
+     *
+     * The coordinates and the hashes of all the tilings are computed
+     * together, field by field, in loops over the tilings that the
+     * compiler can vectorize.
+     */
+    template<concepts::reflected T>
+    class hashed {
+    public:
+
+      static constexpr std::size_t dim = nb_fields<T>;
+      using input_type = T;
+
+    private:
+
+      std::array<double, dim> min;
+      std::array<double, dim> scale;  // Tiles per unit, along each field.
+      unsigned int tilings;
+      std::uint64_t table_size;
+      std::vector<double> offsets;    // offsets[i * tilings + t] is the offset of tiling t along field i.
+
+    public:
+
+      hashed()                         = delete;
+      hashed(const hashed&)            = default;
+      hashed& operator=(const hashed&) = default;
+
+      /**
+       * @param min, max The box that is split into divisions tiles along each field.
+       * @param table_size The number of features, it must be lower than 2^32.
+       */
+      hashed(const std::array<double, dim>& min, const std::array<double, dim>& max, unsigned int divisions, unsigned int tilings, std::size_t table_size)
+	: min(min), tilings(tilings), table_size(table_size), offsets(dim * tilings) {
+	if(divisions == 0 || tilings == 0 || tilings > max_tilings)
+	  throw std::invalid_argument("gdyn::tiles::hashed : divisions and tilings must be in [1, max_tilings]");
+	if(table_size == 0 || table_size > (std::uint64_t(1) << 32))
+	  throw std::invalid_argument("gdyn::tiles::hashed : table_size must be in [1, 2^32]");
+	for(std::size_t i = 0; i < dim; ++i) {
+	  if(!(max[i] > min[i]))
+	    throw std::invalid_argument("gdyn::tiles::hashed : empty box");
+	  scale[i] = divisions / (max[i] - min[i]);
+	  for(unsigned int t = 0; t < tilings; ++t)
+	    offsets[i * tilings + t] = static_cast<double>((t * (2 * i + 1)) % tilings) / tilings;
+	}
+      }
+
+      std::size_t  size()       const {return table_size;}
+      unsigned int nb_tilings() const {return tilings;}
+
+      void operator()(const T& value, std::span<std::size_t> active) const {
+	auto x = as_array(value);
+	std::array<std::uint64_t, max_tilings> h;
+	for(unsigned int t = 0; t < tilings; ++t) h[t] = (t + 1) * 0x9E3779B97F4A7C15ull;
+	for(std::size_t i = 0; i < dim; ++i) {
+	  double c = (x[i] - min[i]) * scale[i];
+	  const double* off = offsets.data() + i * tilings;
+	  for(unsigned int t = 0; t < tilings; ++t)
+	    h[t] = (h[t] ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(c + off[t])))) * 0xBF58476D1CE4E5B9ull;
+	}
+	// The high bits are the best mixed ones, they are mapped to
+	// [0, table_size) by a multiplication rather than a modulo.
+	for(unsigned int t = 0; t < tilings; ++t)
+	  active[t] = static_cast<std::size_t>(((h[t] >> 32) * table_size) >> 32);
+      }
+    };
+
+
+    /**
+     * This is a linear Q function on the features of a coder, with a
+     * weight vector per command. It is a controller as well: called
+     * with an observation, it returns the greedy command.
+     */
+    template<typename CODER, concepts::enumerable COMMAND>
+    class linear_q {
+    public:
+
+      using observation_type = typename CODER::input_type;
+      using command_type     = COMMAND;
+
+    private:
+
+      CODER coder;
+      std::vector<double> w; // The weights of command a are w[a * coder.size(), (a + 1) * coder.size()).
+
+      std::span<const double> weights(std::size_t rank) const {return {w.data() + rank * coder.size(), coder.size()};}
+      std::span<double>       weights(std::size_t rank)       {return {w.data() + rank * coder.size(), coder.size()};}
+
+    public:
+
+      linear_q()                           = delete;
+      linear_q(const linear_q&)            = default;
+      linear_q& operator=(const linear_q&) = default;
+      linear_q(linear_q&&)                 = default;
+      linear_q& operator=(linear_q&&)      = default;
+
+      linear_q(const CODER& coder, double initial_value = 0)
+	: coder(coder), w(cardinal<COMMAND> * coder.size(), initial_value / coder.nb_tilings()) {}
+
+      double value(const observation_type& observation, const COMMAND& command) const {
+	std::array<std::size_t, max_tilings> active;
+	std::span<std::size_t> a(active.data(), coder.nb_tilings());
+	coder(observation, a);
+	return dot(weights(index_of(command)), a);
+      }
+
+      /**
+       * This returns the best command and its value. The features
+       * are computed once for all the commands.
+       */
+      std::pair<COMMAND, double> best(const observation_type& observation) const {
+	std::array<std::size_t, max_tilings> active;
+	std::span<std::size_t> a(active.data(), coder.nb_tilings());
+	coder(observation, a);
+	std::size_t best_rank = 0;
+	double best_value = dot(weights(0), a);
+	for(std::size_t r = 1; r < cardinal<COMMAND>; ++r)
+	  if(double v = dot(weights(r), a); v > best_value) {
+	    best_value = v;
+	    best_rank = r;
+	  }
+	return {value_of<COMMAND>(best_rank), best_value};
+      }
+
+      COMMAND operator()(const observation_type& observation) const {return best(observation).first;}
+
+      /**
+       * This moves the value of (observation, command) towards target,
+       * with a learning rate alpha, and returns the former error.
+       */
+      double learn(const observation_type& observation, const COMMAND& command, double target, double alpha) {
+	std::array<std::size_t, max_tilings> active;
+	std::span<std::size_t> a(active.data(), coder.nb_tilings());
+	coder(observation, a);
+	auto wa = weights(index_of(command));
+	double error = target - dot(wa, a);
+	add(wa, a, alpha * error / a.size());
+	return error;
+      }
+    };
+  }
+}
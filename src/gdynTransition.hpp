@@ -19,8 +19,13 @@ limitations under the License.
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <iostream>
+#include <ranges>
+#include <span>
 #include <tuple>
 
 #include <gdynConcepts.hpp>
@@ -81,6 +86,71 @@ namespace gdyn {
   };
 
 
+  /**
+   * This is a transition spanning several steps of an orbit. The
+   * report is the discounted sum of the reports of the steps, and
+   * the next observation is the one reached after the steps. There
+   * are less steps than asked for when the episode ends before.
+   */
+  template<typename OBSERVATION, typename COMMAND, typename REPORT>
+  struct n_step_transition {
+    OBSERVATION            observation;      //!< the current observation
+    COMMAND                command;          //!< the current command
+    REPORT                 report;           //!< the discounted sum of the step reports
+    OBSERVATION            next_observation; //!< the observation after the steps
+    std::optional<COMMAND> next_command;     //!< the command after the steps (missing if the system has reached a terminal state).
+    unsigned int           steps;            //!< the number of steps
+    double                 discount;         //!< gamma^steps, for bootstrapping from next_observation.
+
+    bool is_terminal() const {return !(next_command.has_value());}
+  };
+
+  
+  /**
+   * This is a transition whose observations, command and report are
+   * stored elsewhere (e.g. in a store::episodes). It is read as a
+   * transition, and it can be converted into one.
+   */
+  template<typename OBSERVATION, typename COMMAND, typename REPORT>
+  struct transition_ref {
+    const OBSERVATION&     observation;
+    const COMMAND&         command;
+    const REPORT&          report;
+    const OBSERVATION&     next_observation;
+    std::optional<COMMAND> next_command;
+
+    bool is_terminal() const {return !(next_command.has_value());}
+
+    operator transition<OBSERVATION, COMMAND, REPORT>() const {
+      return {observation, command, report, next_observation, next_command};
+    }
+  };
+
+  
+  /**
+   * This is a batch of transitions, stored as a structure of arrays
+   * (one contiguous array per transition field), so that batch
+   * updates can loop over each field. The arrays are owned by the
+   * producer of the batch (e.g. a minibatch view iterator).
+   */
+  template<typename OBSERVATION, typename COMMAND, typename REPORT>
+  struct minibatch {
+    std::span<const OBSERVATION>            observations;
+    std::span<const COMMAND>                commands;
+    std::span<const REPORT>                 reports;
+    std::span<const OBSERVATION>            next_observations;
+    std::span<const std::optional<COMMAND>> next_commands;
+    std::span<const std::uint8_t>           terminals;  //!< 1 for terminal transitions, 0 otherwise (handy as a mask).
+
+    std::size_t size()  const {return observations.size();}
+    bool        empty() const {return observations.empty();}
+    
+    transition_ref<OBSERVATION, COMMAND, REPORT> operator[](std::size_t i) const {
+      return {observations[i], commands[i], reports[i], next_observations[i], next_commands[i]};
+    }
+  };
+
+  
   /**
    * This builds a transition.
    *
@@ -92,6 +162,47 @@ namespace gdyn {
     return transition<typename ORBIT_POINT::observation_type, typename ORBIT_POINT::command_type, typename ORBIT_POINT::report_type>(current.current_observation, *(current.next_command), *(next.previous_report), next.current_observation, next.next_command);
   }
 
-  
-		   
+
+  /**
+   * These hash and compare histories, i.e. contiguous ranges of orbit
+   * points (e.g. the spans yielded by views::history, or vectors of
+   * orbit points). A history is made of the observations of its
+   * points, and of the commands performed between them (the next
+   * command of the last point, not performed yet, is ignored). The
+   * observations and commands must be hashable by std::hash. Both are
+   * transparent, so that a table whose keys are vectors of points can
+   * be searched with spans.
+   */
+  struct history_hash {
+    using is_transparent = void;
+    template<std::ranges::contiguous_range HISTORY>
+    std::size_t operator()(const HISTORY& history) const {
+      using point_type = std::ranges::range_value_t<HISTORY>;
+      std::size_t size = std::ranges::size(history);
+      auto p = std::ranges::data(history);
+      std::size_t h = size;
+      for(std::size_t i = 0; i < size; ++i) {
+	h = h * 0x9E3779B97F4A7C15ull + std::hash<typename point_type::observation_type>()(p[i].current_observation);
+	if(i + 1 < size && p[i].next_command)
+	  h = h * 0x9E3779B97F4A7C15ull + std::hash<typename point_type::command_type>()(*(p[i].next_command));
+      }
+      return h;
+    }
+  };
+
+  struct history_equal {
+    using is_transparent = void;
+    template<std::ranges::contiguous_range HISTORY_A, std::ranges::contiguous_range HISTORY_B>
+    bool operator()(const HISTORY_A& a, const HISTORY_B& b) const {
+      std::size_t size = std::ranges::size(a);
+      if(size != std::ranges::size(b)) return false;
+      auto pa = std::ranges::data(a);
+      auto pb = std::ranges::data(b);
+      for(std::size_t i = 0; i < size; ++i) {
+	if(!(pa[i].current_observation == pb[i].current_observation)) return false;
+	if(i + 1 < size && !(pa[i].next_command == pb[i].next_command)) return false;
+      }
+      return true;
+    }
+  };
 }